@@ -0,0 +1,835 @@
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <chrono>
+
+#include "subspace.h"
+#include "ensemble.h"
+#include "analysis.h"
+#include "offline.h"
+#include "synthetic.h"
+#include "audio.h"
+#include "recorder.h"
+#include "realtime.h"
+#include "filter.h"
+#include "Ribbon.h"
+#include "Canvas.h"
+
+#define BSIZE 64
+#define SECONDS 2
+
+// tolerances of the checks: subspace distances (0 to 1) between trackers
+// that differ only in rounding, except toeplitz, whose autocorrelation only
+// approximates qr's covariance (a few percent here); and pixels between
+// geometry computed in float and in double
+#define FIXED 1e-6
+#define SVD 1e-6
+#define POLAR 1e-6
+#define TOEPLITZ 0.1
+#define GEOMETRY 0.01
+
+using namespace soundmath;
+
+// delays spread evenly over [0, span]
+std::vector<uint> ladder(int N, int span = SR / 120)
+{
+	std::vector<uint> delays(N);
+	for (int i = 0; i < N; i++)
+		delays[i] = (N > 1) ? (uint)((double)i * span / (N - 1)) : 0;
+	return delays;
+}
+
+float input[MAX_SR * SECONDS]; // SR * SECONDS of it are used
+
+int checks = 0, failures = 0; // main returns non-zero if any check fails
+
+// a correctness check: value (an error of some kind) must be at most
+// tolerance. prints nothing unless it fails
+void check(const std::string& name, double value, double tolerance)
+{
+	checks++;
+	if (value <= tolerance) // false for nan too
+		return;
+
+	failures++;
+	std::cout << "FAILED " << name << ": " << std::scientific << value << " > " << tolerance << std::fixed << std::endl;
+}
+
+// a tracker built after srand(1), so two built with it start from the same random basis
+template <typename Tracker, typename... Args> Tracker seeded(Args&&... args)
+{
+	srand(1);
+	return Tracker(std::forward<Args>(args)...);
+}
+
+// input samples i to i + BSIZE through a tracker, as one callback would
+template <typename Tracker> void step(Tracker& tracker, int i, bool batched)
+{
+	typedef typename std::decay<decltype(tracker.basis())>::type::Scalar T; // real or complex
+	T trajectories[8 * BSIZE]; // up to k = 8
+	typename Eigen::NumTraits<T>::Real distances[BSIZE];
+
+	if (batched)
+		tracker.batch(input + i, BSIZE, 1, trajectories, distances);
+	else
+		tracker.process(input + i, BSIZE, 1, trajectories, distances);
+}
+
+// wall-clock seconds per call of f, over times calls
+template <typename F> double timed(F f, int times = 1)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (int t = 0; t < times; t++)
+		f();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / times;
+}
+
+// run SECONDS of audio through a tracker one callback at a time; returns wall-clock seconds
+template <typename Tracker> double run(Tracker& tracker, bool batched = false)
+{
+	return timed([&]()
+	{
+		for (int i = 0; i + BSIZE <= SR * SECONDS; i += BSIZE)
+			step(tracker, i, batched);
+	});
+}
+
+// two trackers run side by side on the same input: the seconds each took,
+// and how far apart their subspaces were (0 = same plane, 1 = orthogonal)
+// after each callback, past the first tenth of a second
+struct Paired
+{
+	double seconds[2] = {0, 0};
+	double mean = 0, worst = 0;
+};
+
+template <typename A, typename B> Paired paired(A& reference, B& other, bool batched = false)
+{
+	Paired result;
+	int count = 0;
+	for (int i = 0; i + BSIZE <= SR * SECONDS; i += BSIZE)
+	{
+		result.seconds[0] += timed([&]() { step(reference, i, batched); });
+		result.seconds[1] += timed([&]() { step(other, i, batched); });
+
+		if (i >= SR / 10) // skip the initial transient
+		{
+			double error = other.error(reference) / sqrt(2);
+			result.mean += error;
+			result.worst = std::max(result.worst, error);
+			count++;
+		}
+	}
+	result.mean /= std::max(1, count);
+	return result;
+}
+
+void report(const std::string& name, double seconds)
+{
+	double rate = SR * SECONDS / seconds;
+	std::cout << std::setw(28) << std::left << name
+			  << std::setw(14) << std::right << std::fixed << std::setprecision(0) << rate << " samples/s"
+			  << std::setw(10) << std::setprecision(3) << SR / rate << " cpu load" << std::endl;
+}
+
+// print the distance between a pair, and check the worst of it; the
+// default tolerance of 1 only prints, as no two planes are further apart
+void agree(const std::string& name, const Paired& pair, double tolerance = 1)
+{
+	std::cout << std::setw(28) << std::left << "" << name << std::scientific << std::setprecision(2)
+			  << ": mean " << pair.mean << ", worst " << pair.worst << std::fixed << std::endl;
+	check(name, pair.worst, tolerance);
+}
+
+// per-sample throughput of the dynamic-size tracker against its fixed-size
+// instantiation, which must track the same subspace
+template <int N> void specialized(Tracking mode, const std::string& name)
+{
+	auto dynamic = seeded<Subspace<double>>(ladder(N), 2, 0.999, 0.05, mode, true, true);
+	auto fixed = seeded<Subspace<double, N, 2>>(ladder(N), 2, 0.999, 0.05, mode, true, true);
+	Paired pair = paired(dynamic, fixed);
+
+	report(name + " N = " + std::to_string(N), pair.seconds[0]);
+	report(name + " N = " + std::to_string(N) + " fixed", pair.seconds[1]);
+	std::cout << std::setw(28) << std::left << "" << std::setprecision(2) << pair.seconds[0] / pair.seconds[1] << "x speedup" << std::endl;
+	agree(name + "N = " + std::to_string(N) + " fixed against dynamic", pair, FIXED);
+}
+
+// per-sample cost of the Procrustes correction with JacobiSVD against the
+// polar.h kernels, which must keep the same subspace
+template <int N, int K> void procrustes(Tracking mode, const std::string& name)
+{
+	auto exact = seeded<Subspace<double, N, K>>(ladder(N), K, 0.999, 0.05, mode, true, true);
+	auto fast = seeded<Subspace<double, N, K>>(ladder(N), K, 0.999, 0.05, mode, true, true);
+	exact.procrustes(Polar::exact);
+
+	Paired pair = paired(exact, fast);
+	double before = pair.seconds[0], after = pair.seconds[1];
+	for (int i = 0; i < 2; i++) // best of three
+	{
+		before = std::min(before, run(exact));
+		after = std::min(after, run(fast));
+	}
+	double ns = 1e9 / (SR * SECONDS);
+
+	std::string label = name + " N = " + std::to_string(N) + ", k = " + std::to_string(K);
+	std::cout << std::setw(28) << std::left << label
+			  << std::fixed << std::setprecision(1) << before * ns << " -> " << after * ns << " ns/sample, "
+			  << std::setprecision(0) << 100 * (1 - after / before) << "% removed" << std::endl;
+	agree(label + " kernel against JacobiSVD", pair, POLAR);
+}
+
+// load the first SECONDS of a WAV file (see wavreader.h) into input, mixed
+// down to mono and zero-padded, and switch SR to the file's rate; returns
+// false if it can't be read
+bool load(const char* path)
+{
+	WavReader reader(path);
+	if (!reader.good())
+		return false;
+	if (reader.sampleRate() > MAX_SR)
+		std::cout << path << ": " << reader.sampleRate() << " Hz file, analyzed as " << MAX_SR << " Hz" << std::endl;
+	SR = std::min(MAX_SR, reader.sampleRate());
+
+	int channels = reader.channelCount();
+	float* frames = new float[SR * SECONDS * channels];
+	int count = reader.read(frames, SR * SECONDS);
+
+	memset(input, 0, sizeof(input));
+	for (int i = 0; i < count; i++)
+		for (int c = 0; c < channels; c++)
+			input[i] += frames[channels * i + c] / channels;
+
+	delete [] frames;
+	return count > 0;
+}
+
+// throughput of gradient, qr and svd modes, and subspace error of gradient and
+// svd against qr, on whatever is in input; svd must stay within tolerance of qr
+void descent(const std::string& name, double tolerance)
+{
+	for (int N : {12, 24, 96})
+	{
+		Tracking modes[3] = {Tracking::qr, Tracking::svd, Tracking::gradient};
+		std::string names[3] = {"qr", "svd", "gradient"};
+
+		for (int m = 0; m < 3; m++)
+		{
+			Subspace<double> tracker(ladder(N), 2, 0.999, modes[m] == Tracking::gradient ? 0.01 : 0.05, modes[m], true, true);
+			report(name + " " + names[m] + " N = " + std::to_string(N), run(tracker));
+		}
+
+		// svd is a different factorization of the same update, so it must
+		// agree with qr; gradient descent only follows it
+		for (int m = 1; m < 3; m++)
+		{
+			auto exact = seeded<Subspace<double>>(ladder(N), 2, 0.999, 0.05, Tracking::qr, true, true);
+			auto other = seeded<Subspace<double>>(ladder(N), 2, 0.999, modes[m] == Tracking::gradient ? 0.01 : 0.05, modes[m], true, true);
+			agree(name + " " + names[m] + " N = " + std::to_string(N) + " against qr", paired(exact, other), m == 1 ? tolerance : 1);
+		}
+	}
+}
+
+// Scope's geometry as it was before Ribbon.h: normals with a per-point norm
+// switch, four offset passes, then vertices with three sin() per segment
+double switched(double x, double y, Smoothing type, double smoothing)
+{
+	switch (type)
+	{
+		case constant: return 1;
+		case L2: return sqrt(smoothing * smoothing + x * x + y * y);
+		case L1: return abs(smoothing) + abs(x) + abs(y);
+		case L4: return pow(smoothing * smoothing * smoothing * smoothing + x * x * x * x + y * y * y * y, 0.25);
+		case LHalf: return pow(sqrt(abs(smoothing)) + sqrt(abs(x)) + sqrt(abs(y)), 2);
+		case LInf: return std::max(abs(smoothing), std::max(abs(x), abs(y)));
+	}
+	return 1;
+}
+
+void unfused(const SDL_FPoint* trace, int count, double x0, double y0, double k, double push, double core, double smoothing,
+			 SDL_FPoint* scratch, SDL_Vertex* track, SDL_Vertex* curve)
+{
+	SDL_FPoint* waveform = scratch;
+	SDL_FPoint* normals = scratch + count;
+	SDL_FPoint* offsets[4] = { scratch + 2 * count, scratch + 3 * count, scratch + 4 * count, scratch + 5 * count };
+	double widths[4] = { push, -push, core, -core };
+
+	for (int i = 0; i < count; i++)
+		waveform[i] = { (float)(x0 + k * trace[i].x), (float)(y0 + k * trace[i].y) };
+
+	double dx = waveform[1].x - waveform[0].x, dy = waveform[1].y - waveform[0].y;
+	double scale = switched(dx, dy, L2, smoothing);
+	normals[0] = { (float)(dy / scale), (float)(-dx / scale) };
+
+	dx = waveform[count - 1].x - waveform[count - 2].x, dy = waveform[count - 1].y - waveform[count - 2].y;
+	scale = switched(dx, dy, L2, smoothing);
+	normals[count - 1] = { (float)(dy / scale), (float)(-dx / scale) };
+
+	for (int i = 1; i < count - 1; i++)
+	{
+		double dx1 = (double)waveform[i].x - waveform[i - 1].x, dy1 = (double)waveform[i].y - waveform[i - 1].y;
+		double dx2 = (double)waveform[i + 1].x - waveform[i].x, dy2 = (double)waveform[i + 1].y - waveform[i].y;
+		double scale1 = switched(dx1, dy1, L2, smoothing), scale2 = switched(dx2, dy2, L2, smoothing);
+		dx = (dx1 / scale1 + dx2 / scale2) / 2;
+		dy = (dy1 / scale1 + dy2 / scale2) / 2;
+		normals[i] = { (float)dy, (float)-dx };
+	}
+
+	for (int o = 0; o < 4; o++)
+		for (int i = 0; i < count; i++)
+			offsets[o][i] = { (float)(waveform[i].x + widths[o] * normals[i].x), (float)(waveform[i].y + widths[o] * normals[i].y) };
+
+	SDL_Color white = { 255, 255, 255, 128 };
+	for (int i = 0, j = 0; i < count - 1; i++, j += 6)
+	{
+		unsigned char R = (unsigned char)(255 * (1 + sin(2 * PI * (0.0 / 3 / 2 + (double)i / count))) / 2);
+		unsigned char G = (unsigned char)(255 * (1 + sin(2 * PI * (1.0 / 3 / 2 + (double)i / count))) / 2);
+		unsigned char B = (unsigned char)(255 * (1 + sin(2 * PI * (2.0 / 3 / 2 + (double)i / count))) / 2);
+		SDL_Color color = { R, G, B, 10 };
+
+		SDL_FPoint* L = offsets[0];
+		SDL_FPoint* R_ = offsets[1];
+		track[j] = { R_[i], color, SDL_FPoint{ 0 } };
+		track[j + 1] = { R_[i + 1], color, SDL_FPoint{ 0 } };
+		track[j + 2] = { L[i], color, SDL_FPoint{ 0 } };
+		track[j + 3] = { L[i], color, SDL_FPoint{ 0 } };
+		track[j + 4] = { L[i + 1], color, SDL_FPoint{ 0 } };
+		track[j + 5] = { R_[i + 1], color, SDL_FPoint{ 0 } };
+
+		L = offsets[2];
+		R_ = offsets[3];
+		curve[j] = { R_[i], white, SDL_FPoint{ 0 } };
+		curve[j + 1] = { R_[i + 1], white, SDL_FPoint{ 0 } };
+		curve[j + 2] = { L[i], white, SDL_FPoint{ 0 } };
+		curve[j + 3] = { L[i], white, SDL_FPoint{ 0 } };
+		curve[j + 4] = { L[i + 1], white, SDL_FPoint{ 0 } };
+		curve[j + 5] = { R_[i + 1], white, SDL_FPoint{ 0 } };
+	}
+}
+
+// distance from p to the polyline through every other vertex of edges, starting at first
+double stray(SDL_FPoint p, const SDL_Vertex* edges, int first, int count)
+{
+	double nearest = 1e30;
+	for (int j = 0; j + 1 < count; j++)
+	{
+		SDL_FPoint a = edges[2 * j + first].position, b = edges[2 * (j + 1) + first].position;
+		double dx = b.x - a.x, dy = b.y - a.y;
+		double length = dx * dx + dy * dy;
+		double t = length > 0 ? std::max(0.0, std::min(1.0, ((p.x - a.x) * dx + (p.y - a.y) * dy) / length)) : 0;
+		nearest = std::min(nearest, std::hypot(a.x + t * dx - p.x, a.y + t * dy - p.y));
+	}
+	return nearest;
+}
+
+// a frame of Scope's trace, input against itself 50 ms later, and its palette
+void scope(SDL_FPoint* trace, SDL_Color* palette, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		trace[i] = { input[i], input[(i + SR / 20) % (SR * SECONDS)] };
+		for (int c = 0; c < 3; c++)
+			(&palette[i].r)[c] = (unsigned char)(255 * (1 + sin(2 * PI * (c / 3.0 / 2 + (double)i / count))) / 2);
+		palette[i].a = 10;
+	}
+}
+
+// Scope's -f path: a recording of input (left) and its negation (right)
+// played back through Audio::render, which only hands process() a block
+long blocks = 0, stop = 0; // stop after this many blocks, if non-zero
+double mismatch = 0;
+int playback(const float* in, float*)
+{
+	for (int i = 0; i < BSIZE; i++)
+	{
+		long frame = blocks * BSIZE + i;
+		double left = frame < SR ? input[frame] : 0, right = -left; // the last block is padded
+		mismatch = std::max(mismatch, std::max(std::abs(in[2 * i] - left), std::abs(in[2 * i + 1] - right)));
+	}
+	blocks++;
+	return stop && blocks >= stop;
+}
+
+// usage: bench [file.wav ...]; files (e.g. OrchideaSOL samples) are compared
+// across the qr, svd and gradient modes after the synthetic benchmarks. exits
+// non-zero if a check fails: implementations that must agree (fixed and
+// dynamic size, svd and qr, the polar kernels, toeplitz and direct products,
+// fused and old geometry, batched and single triangles) differ by more than
+// rounding, or decimated geometry strays past its tolerance
+int main(int argc, char* argv[])
+{
+	for (int i = 0; i < SR * SECONDS; i++)
+		input[i] = 0.5 * sin(2 * PI * 220 * i / SR) + 0.25 * sin(2 * PI * 660 * i / SR) + 0.01 * (2 * ((double)rand() / RAND_MAX) - 1);
+
+	std::cout << "SR = " << SR << ", bsize = " << BSIZE << ", k = 2" << std::endl << std::endl;
+
+	for (int N : {2, 3, 5, 12, 24})
+	{
+		Subspace<double> tracker(ladder(N), 2, 0.999, 0.05, Tracking::qr, true, true);
+		report("qr   N = " + std::to_string(N), run(tracker));
+	}
+
+	for (int N : {2, 3, 5, 12, 24})
+	{
+		Subspace<double> tracker(ladder(N), 2, 0.999, 0.05, Tracking::svd, true, true);
+		report("svd  N = " + std::to_string(N), run(tracker));
+	}
+
+	for (int N : {2, 3, 5, 12, 24, 96, 256, 512})
+	{
+		Subspace<double> tracker(ladder(N), 2, 0.999, 0.05, Tracking::past, true, true);
+		report("past N = " + std::to_string(N), run(tracker));
+	}
+
+	std::cout << std::endl << "per-sample vs. batched (bsize " << BSIZE << ")" << std::endl;
+	for (int N : {5, 12, 24, 96})
+	{
+		Subspace<double> sampled(ladder(N), 2, 0.999, 0.05, Tracking::qr, true, true);
+		Subspace<double> batched(ladder(N), 2, 0.999, 0.05, Tracking::qr, true, true);
+		report("qr   N = " + std::to_string(N), run(sampled));
+		report("qr   N = " + std::to_string(N) + " batched", run(batched, true));
+	}
+
+	std::cout << std::endl << "dynamic vs. fixed-size" << std::endl;
+	for (Tracking mode : {Tracking::qr, Tracking::svd})
+	{
+		std::string name = (mode == Tracking::qr) ? "qr  " : "svd ";
+		specialized<2>(mode, name);
+		specialized<3>(mode, name);
+		specialized<5>(mode, name);
+		specialized<12>(mode, name);
+		specialized<24>(mode, name);
+	}
+
+	std::cout << std::endl << "JacobiSVD vs. closed-form (k = 2, 3) and Jacobi (k > 3) rotations" << std::endl;
+	for (Tracking mode : {Tracking::qr, Tracking::svd})
+	{
+		std::string name = (mode == Tracking::qr) ? "qr  " : "svd ";
+		procrustes<12, 2>(mode, name);
+		procrustes<24, 2>(mode, name);
+		procrustes<12, 3>(mode, name);
+		procrustes<24, 3>(mode, name);
+		procrustes<24, 4>(mode, name);
+		procrustes<48, 8>(mode, name);
+	}
+
+	std::cout << std::endl << "qr vs. toeplitz (FFT) covariance products, uniform ladder, batched" << std::endl;
+	for (int N : {96, 256, 512})
+	{
+		std::vector<uint> delays(N);
+		for (int i = 0; i < N; i++)
+			delays[i] = i;
+
+		auto direct = seeded<Subspace<double>>(delays, 2, 0.999, 0.05, Tracking::qr, true, true);
+		auto fast = seeded<Subspace<double>>(delays, 2, 0.999, 0.05, Tracking::toeplitz, true, true);
+		Paired pair = paired(direct, fast, true);
+		report("qr       N = " + std::to_string(N), pair.seconds[0]);
+		report("toeplitz N = " + std::to_string(N), pair.seconds[1]);
+		agree("toeplitz N = " + std::to_string(N) + " against qr", pair, TOEPLITZ);
+	}
+
+	std::cout << std::endl << "double vs. float (error: subspace distance between the two)" << std::endl;
+	for (Tracking mode : {Tracking::qr, Tracking::past})
+		for (int N : {12, 24, 96, 256})
+		{
+			auto precise = seeded<Subspace<double>>(ladder(N), 2, 0.999, 0.05, mode, true, true);
+			auto fast = seeded<Subspace<float>>(ladder(N), 2, 0.999, 0.05, mode, true, true);
+			Paired pair = paired(precise, fast, true);
+
+			std::string name = (mode == Tracking::qr) ? "qr   N = " : "past N = ";
+			report(name + std::to_string(N) + " double", pair.seconds[0]);
+			report(name + std::to_string(N) + " float", pair.seconds[1]);
+			std::cout << std::setw(28) << std::left << "" << std::setprecision(2) << pair.seconds[0] / pair.seconds[1] << "x speedup, error "
+					  << std::scientific << "mean " << pair.mean << ", worst " << pair.worst << ", "
+					  << fast.refinements() << " refinements" << std::fixed << std::endl;
+		}
+
+	std::cout << std::endl << "real vs. complex (analytic signal) trackers, k = 1 complex against k = 2 real" << std::endl;
+	for (int N : {12, 24, 96})
+		for (Tracking mode : {Tracking::qr, Tracking::past})
+		{
+			std::string name = ((mode == Tracking::qr) ? "qr   N = " : "past N = ") + std::to_string(N);
+			Subspace<double> real(ladder(N), 2, 0.999, 0.05, mode, true, true);
+			Subspace<std::complex<double>> complex(ladder(N), 1, 0.999, 0.05, mode, true, true);
+			Subspace<std::complex<float>> single(ladder(N), 1, 0.999, 0.05, mode, true, true);
+			report(name + " double", run(real, true));
+			report(name + " complex<double>", run(complex, true));
+			report(name + " complex<float>", run(single, true));
+		}
+
+	std::cout << std::endl << "qr vs. svd vs. gradient (Cayley), gradient with delta = 0.01" << std::endl;
+	descent("synthetic", SVD);
+
+	// the video configurations are dominated by the N = 96 tracker, so they
+	// mostly measure the shared gather; four equal ladders show the threading
+	std::vector<std::vector<uint>> videos = {{0, 800}, {0, 191, 307, 491, 797}, {}, {}};
+	for (int i = 0; i < 20; i++)
+		videos[2].push_back(i * (i + 1) / 2);
+	for (int i = 0; i < 96; i++)
+		videos[3].push_back(i);
+	std::vector<std::vector<uint>> equal;
+	for (int s = 1; s <= 4; s++)
+		equal.push_back(ladder(64, s * SR / 480));
+
+	for (int w = 0; w < 2; w++)
+	{
+		const std::vector<std::vector<uint>>& sets = w ? equal : videos;
+		std::cout << std::endl << (w ? "four N = 64 ladders" : "the four video configurations")
+				  << ", separately vs. as an ensemble" << std::endl;
+
+		double separate = 0;
+		for (const std::vector<uint>& delays : sets)
+		{
+			Subspace<double> tracker(delays, 2, 0.999, 0.05, Tracking::svd, true, true);
+			separate += run(tracker, true);
+		}
+		report("separate", separate);
+
+		for (int threads : {1, -1})
+		{
+			Ensemble<double> ensemble(BSIZE, threads);
+			for (const std::vector<uint>& delays : sets)
+				ensemble.add(delays, 2, 0.999, 0.05, Tracking::svd, true, true);
+
+			report("ensemble, " + std::to_string(ensemble.concurrency()) + " thread(s)", timed([&]()
+			{
+				for (int i = 0; i + BSIZE <= SR * SECONDS; i += BSIZE)
+					ensemble.process(input + i, BSIZE);
+			}));
+		}
+	}
+
+	std::cout << std::endl << "analysis thread fed in real time by simulated callbacks, per-sample qr N = 256 / 64 / 16" << std::endl;
+	for (Policy policy : {Policy::drop, Policy::decimate, Policy::degrade})
+	{
+		Subspace<double>* trackers[3];
+		int sizes[3] = {256, 64, 16};
+		for (int l = 0; l < 3; l++)
+			trackers[l] = new Subspace<double>(ladder(sizes[l]), 2, 0.999, 0.05, Tracking::qr, true, true);
+
+		// decimated blocks stretch these ladders by factor() (see analysis.h);
+		// this measures scheduling, not the embedding
+		Analysis<> analysis([&](const float* in, int frames, int stride, int level)
+		{
+			trackers[level]->process(in, frames, stride);
+		}, BSIZE, policy, 0.02, 3);
+		analysis.start();
+
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i + BSIZE <= SR; i += BSIZE) // one second
+		{
+			std::this_thread::sleep_until(start + std::chrono::microseconds((long)i * 1000000 / SR));
+			analysis.push(input + i, BSIZE);
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		analysis.stop();
+
+		std::string names[3] = {"drop", "decimate", "degrade"};
+		std::cout << std::setw(28) << std::left << names[policy] << std::setprecision(3)
+				  << analysis.blocks() << " blocks, " << analysis.late() << " late, " << analysis.dropped() << " dropped, lateness mean "
+				  << 1000 * analysis.lateness() << " ms, worst " << 1000 * analysis.worst() << " ms, load " << analysis.load() << std::endl;
+
+		for (int l = 0; l < 3; l++)
+			delete trackers[l];
+	}
+
+	std::cout << std::endl << "null device, a per-sample qr tracker in the callback, saw plus noise input" << std::endl;
+	for (int N : {24, 96, 256})
+	{
+		Subspace<double> tracker(ladder(N), 2, 0.999, 0.05, Tracking::qr, true, true);
+		Synthetic null([&](const float* in, float*, unsigned long frames)
+		{
+			tracker.process(in, frames);
+			return 0;
+		}, &saw, 220, 0.5, 0.01, BSIZE);
+
+		for (bool paced : {true, false})
+		{
+			null.run(0.5, paced, NULL, false);
+			std::cout << std::setw(28) << std::left << "N = " + std::to_string(N) + (paced ? " paced" : " free-running")
+					  << std::setprecision(3) << null.factor() << "x real time, load " << null.load() << ", "
+					  << null.misses() << " deadline misses" << std::endl;
+		}
+	}
+
+	std::cout << std::endl << "a second recorded to float WAV, then played back through Audio::render (Scope -f)" << std::endl;
+	{
+		std::string path = std::string(P_tmpdir) + "/bench-" + std::to_string(getpid()) + ".wav";
+		Recorder recorder(path, 2, SR);
+		if (recorder.start())
+		{
+			float frames[2 * BSIZE];
+			for (int b = 0; b * BSIZE < SR; b++)
+			{
+				int count = std::min(BSIZE, SR - b * BSIZE);
+				for (int i = 0; i < count; i++)
+					frames[2 * i + 1] = -(frames[2 * i] = input[b * BSIZE + i]);
+				recorder.push(frames, count);
+			}
+			recorder.stop();
+
+			Audio A(playback, BSIZE);
+			double factor = A.render(path, 2, 1, false);
+			std::cout << std::setw(28) << std::left << "whole file" << blocks << " blocks, " << std::fixed << std::setprecision(0)
+					  << factor << "x real time, " << std::scientific << mismatch << std::fixed << " worst error" << std::endl;
+			check("frames played back against recorded", std::abs(blocks * BSIZE - SR), BSIZE - 1);
+			check("samples played back against recorded", mismatch, 0);
+			check("stream time after playback", std::abs(A.time - (double)blocks * BSIZE / SR), 1e-9);
+
+			// a process() that returns non-zero, like a callback returning paComplete, ends the file early
+			blocks = 0;
+			stop = 3;
+			A.render(path, 2, 1, false);
+			check("blocks played after asking to stop", std::abs(blocks - stop), 0);
+		}
+		else
+			check("recording a file to play back", 1, 0);
+		remove(path.c_str());
+	}
+
+	std::cout << std::endl << "a bank of 64 resonators ringing out into silence, before and after real-time setup" << std::endl;
+	for (bool prepared : {false, true})
+	{
+		// a fresh thread each time, since the ftz/daz flags are per thread
+		std::thread thread([prepared]()
+		{
+			Realtime realtime(80, 0);
+			if (prepared)
+			{
+				realtime.prepare();
+				realtime.enter();
+				realtime.report(std::cout);
+			}
+
+			std::vector<Filter<double>> bank(64, Filter<double>({0, 0, 0}, {0, 0, 0}));
+			for (int j = 0; j < 64; j++)
+			{
+				bank[j].resonant(100 + 50 * j, 0.98);
+				bank[j].reset();
+			}
+
+			bool struck = false;
+			Timing timing;
+			Synthetic null([&](const float*, float* out, unsigned long frames)
+			{
+				for (unsigned long i = 0; i < frames; i++)
+				{
+					float impulse = struck ? 0 : 1;
+					struck = true;
+					out[i] = 0;
+					for (Filter<double>& filter : bank)
+					{
+						out[i] += filter(impulse);
+						filter.tick();
+					}
+				}
+				return 0;
+			}, NULL, 0, 0, 0, BSIZE);
+
+			null.run(1, true, &timing, false);
+			std::cout << std::setw(28) << std::left << (prepared ? "after" : "before") << std::fixed << std::setprecision(1)
+					  << "callback mean " << 1e6 * timing.mean() << " us, worst " << 1e6 * timing.worst() << " us, "
+					  << null.misses() << " deadline misses" << std::endl;
+			realtime.release(); // MCL_FUTURE would otherwise skew every section after this one
+		});
+		thread.join();
+	}
+
+	std::cout << std::endl << "one frame of Scope geometry (" << SR / 60 << " points) from trace to vertices, before and after fusing and indexing" << std::endl;
+	for (int screen : {1080, 2160})
+	{
+		int count = SR / 60;
+		double scale = screen; // square tile of the screen's height, at highDPI
+		double k = 2 * 5 * scale / 2;
+		double smoothing = 256.0 / count;
+
+		SDL_FPoint* trace = new SDL_FPoint[count];
+		SDL_FPoint* scratch = new SDL_FPoint[6 * count];
+		SDL_Color* palette = new SDL_Color[count];
+		SDL_Vertex* before[2] = { new SDL_Vertex[6 * count], new SDL_Vertex[6 * count] };
+		SDL_Vertex* after[2] = { new SDL_Vertex[2 * count], new SDL_Vertex[2 * count] };
+		int* indices = new int[6 * (count - 1)];
+		ribbon_indices(count, indices);
+		scope(trace, palette, count);
+
+		double seconds[2];
+		seconds[0] = timed([&]()
+		{
+			unfused(trace, count, screen, screen, k, 192 * scale / 1080, 5 * scale / 1080, smoothing, scratch, before[0], before[1]);
+		}, 2000);
+		seconds[1] = timed([&]()
+		{
+			ribbon<L2>(trace, count, screen, screen, k, 192 * scale / 1080, 5 * scale / 1080, smoothing, palette, SDL_Color{ 255, 255, 255, 128 }, after[0], after[1]);
+		}, 2000);
+
+		double error = 0;
+		for (int r = 0; r < 2; r++)
+			for (int i = 0; i < 6 * (count - 1); i++)
+			{
+				const SDL_FPoint& a = before[r][i].position;
+				const SDL_FPoint& b = after[r][indices[i]].position;
+				error = std::max(error, (double)std::max(std::abs(a.x - b.x), std::abs(a.y - b.y)));
+			}
+
+		std::cout << std::setw(28) << std::left << std::to_string(screen) + "p" << std::fixed << std::setprecision(1)
+				  << "before " << 1e6 * seconds[0] << " us, after " << 1e6 * seconds[1] << " us, "
+				  << std::setprecision(4) << "largest difference " << error << " px, "
+				  << 2 * 6 * (count - 1) * sizeof(SDL_Vertex) / 1024 << " kB of vertices before, " << 2 * 2 * count * sizeof(SDL_Vertex) / 1024 << " kB after" << std::endl;
+		check(std::to_string(screen) + "p fused geometry against the old", error, GEOMETRY);
+
+		delete [] trace;
+		delete [] scratch;
+		delete [] palette;
+		delete [] indices;
+		for (int r = 0; r < 2; r++)
+		{
+			delete [] before[r];
+			delete [] after[r];
+		}
+	}
+
+	std::cout << std::endl << "one frame of Scope geometry at 1080p, decimated to a pixel tolerance" << std::endl;
+	for (int low = 0; low < 2; low++)
+	{
+		int count = SR / 60;
+		double k = 2 * 5 * 1080 / 2;
+		SDL_FPoint* trace = new SDL_FPoint[count];
+		SDL_Color* palette = new SDL_Color[count];
+		SDL_Vertex* full[2] = { new SDL_Vertex[2 * count], new SDL_Vertex[2 * count] };
+		SDL_Vertex* decimated[2] = { new SDL_Vertex[2 * count], new SDL_Vertex[2 * count] };
+		scope(trace, palette, count);
+		if (low) // a quiet 55 Hz sine
+			for (int i = 0; i < count; i++)
+				trace[i] = { 0.05f * (float)sin(2 * PI * 55 * i / SR), 0.05f * (float)sin(2 * PI * 55 * (i + SR / 20) / SR) };
+
+		ribbon<L2>(trace, count, 1080, 1080, k, 192, 5, 256.0 / count, palette, SDL_Color{ 255, 255, 255, 128 }, full[0], full[1]);
+
+		for (double tolerance : {0.0, 0.25, 0.5, 1.0})
+		{
+			int kept = 0;
+			double seconds = timed([&]()
+			{
+				kept = ribbon<L2>(trace, count, 1080, 1080, k, 192, 5, 256.0 / count, palette, SDL_Color{ 255, 255, 255, 128 }, decimated[0], decimated[1], tolerance);
+			}, 2000);
+
+			// every vertex of every full edge against the decimated edge
+			double error = 0;
+			for (int r = 0; r < 2; r++)
+				for (int side = 0; side < 2; side++)
+					for (int i = 0; i < count; i++)
+						error = std::max(error, stray(full[r][2 * i + side].position, decimated[r], side, kept));
+
+			std::cout << std::setw(28) << std::left << std::string(low ? "55 Hz sine" : "220 + 660 Hz") + ", " + std::to_string(tolerance).substr(0, 4) + " px"
+					  << std::fixed << std::setprecision(1) << kept << " of " << count << " points, " << 1e6 * seconds << " us, "
+					  << std::setprecision(3) << "largest error " << error << " px" << std::endl;
+			check(std::string(low ? "55 Hz sine" : "220 + 660 Hz") + " decimated past its tolerance", error, tolerance + GEOMETRY);
+		}
+
+		delete [] trace;
+		delete [] palette;
+		for (int r = 0; r < 2; r++)
+		{
+			delete [] full[r];
+			delete [] decimated[r];
+		}
+	}
+
+	std::cout << std::endl << "one frame of Scope (" << SR / 60 << " points) drawn headless into a 1920 x 1080 Canvas" << std::endl;
+	{
+		int count = SR / 60;
+		double k = 1080 / 2; // gain 1, so the trace stays on screen
+		SDL_FPoint* trace = new SDL_FPoint[count];
+		SDL_Color* palette = new SDL_Color[count];
+		SDL_Vertex* verts[2] = { new SDL_Vertex[2 * count], new SDL_Vertex[2 * count] };
+		int* indices = new int[6 * (count - 1)];
+		ribbon_indices(count, indices);
+		scope(trace, palette, count);
+		ribbon<L2>(trace, count, 960, 540, k, 192, 5, 256.0 / count, palette, SDL_Color{ 255, 255, 255, 128 }, verts[0], verts[1]);
+
+		Canvas canvas(1920, 1080);
+		double seconds = timed([&]()
+		{
+			canvas.color(0, 0, 0);
+			canvas.clear();
+			for (int r = 0; r < 2; r++)
+				canvas.geometry(verts[r], 2 * count, indices, 6 * (count - 1));
+			canvas.display();
+		}, 100);
+
+		// the same frame a triangle at a time, which batches nothing
+		Canvas single(1920, 1080);
+		single.color(0, 0, 0);
+		single.clear();
+		for (int r = 0; r < 2; r++)
+			for (int i = 0; i < 6 * (count - 1); i += 3)
+				single.geometry(verts[r], 2 * count, indices + i, 3);
+		long differ = 0;
+		for (int i = 0; i < 1920 * 1080; i++)
+			differ += canvas.pixels()[i] != single.pixels()[i];
+
+		std::cout << std::setw(28) << std::left << "track and core" << std::fixed << std::setprecision(2) << 1e3 * seconds << " ms per frame, "
+				  << std::setprecision(0) << 1 / seconds << " frames/s, " << differ << " pixels differ from drawing triangles one by one" << std::endl;
+		check("batched triangles against single ones", differ, 0);
+
+		// a circle is a fan of triangles around its centre: drawn at half alpha
+		// over black, no pixel may come out brighter than one blend
+		canvas.color(0, 0, 0);
+		canvas.clear();
+		canvas.color(1, 1, 1, 0.5);
+		canvas.circle(960.3, 540.7, 400);
+		long covered = 0, twice = 0;
+		for (int i = 0; i < 1920 * 1080; i++)
+		{
+			int red = canvas.pixels()[i] & 0xFF;
+			covered += red > 0;
+			twice += red > 128;
+		}
+		std::cout << std::setw(28) << std::left << "circle of radius 400" << covered << " pixels covered (" << std::fixed << std::setprecision(0)
+				  << PI * 400 * 400 << " in the true circle), " << twice << " blended twice" << std::endl;
+		check("circle pixels blended twice", twice, 0);
+
+		delete [] trace;
+		delete [] palette;
+		delete [] indices;
+		for (int r = 0; r < 2; r++)
+			delete [] verts[r];
+	}
+
+	std::cout << std::endl << "past vs. qr subspace error (0 = same plane, 1 = orthogonal)" << std::endl;
+	for (int N : {5, 12, 24, 96, 256})
+	{
+		Subspace<double> exact(ladder(N), 2, 0.999, 0.05, Tracking::qr, true, true, 0.01, false);
+		Subspace<double> approximate(ladder(N), 2, 0.999, 0.05, Tracking::past, true, true, 0.01, false);
+		Paired pair = paired(exact, approximate);
+
+		std::cout << std::setw(28) << std::left << "N = " + std::to_string(N)
+				  << std::setprecision(4) << "mean " << pair.mean << ", worst " << pair.worst << std::endl;
+	}
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string name = argv[i];
+		name = name.substr(name.find_last_of('/') + 1);
+
+		std::cout << std::endl << name << std::endl;
+		if (!load(argv[i]))
+		{
+			std::cout << "couldn't read " << argv[i] << " as PCM or float WAV" << std::endl;
+			continue;
+		}
+		std::cout << "SR = " << SR << std::endl;
+		descent(name.substr(0, name.find_last_of('.')), SVD);
+
+		// the whole file, as fast as possible, through the offline backend
+		Subspace<double> tracker(ladder(24), 2, 0.999, 0.05, Tracking::qr, true, true);
+		Offline offline([&](const float* in, float*, unsigned long frames)
+		{
+			tracker.batch(in, frames);
+			return 0;
+		}, BSIZE);
+		offline.run(argv[i]);
+	}
+
+	std::cout << std::endl << checks << " checks, " << failures << " failed" << std::endl;
+	return failures ? 1 : 0;
+}
@@ -2,6 +2,8 @@
 #pragma once
 
 #include "includes.h"
+#include "timing.h"
+#include "realtime.h"
 using namespace soundmath;
 
 // abstract base class
@@ -9,7 +11,7 @@ class AbstractAudio
 {
 public:
 
-	AbstractAudio(int bsize = def_bsize, int SR = def_SR);
+	AbstractAudio(int bsize = def_bsize, int SR = soundmath::SR);
 	~AbstractAudio();
 	
 	static void initialize(bool report = false, int* def_in = NULL, int* def_out = NULL);
@@ -23,9 +25,13 @@ public:
 
 	static PaError clean(PaError err);
 
+	PaTime time = 0; // stream time at which the current block's first input frame was captured
+	Timing timing; // per-callback durations, jitter and xruns
+	Realtime* realtime = NULL; // opt-in setup: startup() locks memory, the callback thread sets itself up on its first call
+	bool entered = false;
+
 private:
 	static const int def_bsize = 16;
-	static const int def_SR = 48000;
 
 protected:
 	int bsize;
@@ -37,6 +43,12 @@ protected:
 	int in_channel;
 	int out_device;
 	int out_chans;
+	std::string timings; // where shutdown() writes the callback statistics, if anywhere
+	std::string file; // if set, startup() processes this WAV file (or stdin) instead of opening a device
+	std::string synthetic; // if set, startup() runs this waveform through a null device instead
+	double seconds = 10; // how long the null device runs
+	bool paced = true; // whether the null device keeps a real device's cadence
+	Realtime setup; // what -rt and -p ask for
 
 	PaStream* stream;
 	PaStreamParameters inParams, outParams;
@@ -0,0 +1,241 @@
+// analysis.h
+#pragma once
+
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include "includes.h"
+#include "ring.h"
+#include "realtime.h"
+
+namespace soundmath
+{
+	// what an Analysis does about a backlog
+	enum Policy
+	{
+		drop, // skip whole blocks to catch up
+		decimate, // analyze every 2nd, 4th, ... sample of the backlog
+		degrade // ask the stage for a cheaper level, e.g. a tracker with fewer delays
+	};
+
+	// heavy analysis (trackers, ensembles, FFTs) on its own thread, fed from the
+	// audio callback through a Ring; push() is wait-free and is all the callback
+	// has to do. the queue holds frames of width items of type T, e.g. one
+	// float per channel, or samples stamped with their time. the worker takes
+	// bsize frames at a time. a block is late when more than deadline seconds
+	// of audio are queued behind it, and the policy then decides how to catch
+	// up; it relaxes once the backlog is under a quarter of the deadline. the
+	// stage is called as stage(in, frames, stride, level): frame i of the block
+	// starts at in[stride * i], and level runs from 0 (full) to levels - 1
+	// (cheapest). stride is width times the decimation factor (see factor()),
+	// and a decimated stage only sees every factor-th frame, so anything it
+	// counts in samples (embedding delays, delay lines, smoothing) stretches
+	// by that factor: divide such lengths by stride / width to keep the same
+	// picture. a stage that wants a pool of threads can be an Ensemble.
+	template <typename T = float> class Analysis
+	{
+	public:
+		typedef std::function<void(const T* in, int frames, int stride, int level)> Stage;
+
+		// capacity is in frames
+		Analysis(Stage stage, int bsize = 64, Policy policy = drop, double deadline = 0.05, int levels = 1, uint capacity = SR, int width = 1)
+			: stage(stage), bsize(std::max(1, bsize)), policy(policy), deadline(deadline), levels(std::max(1, levels)),
+			  width(std::max(1, width)), queue(std::max<uint>(capacity, 2 * most * this->bsize) * this->width)
+		{
+			scratch = new T[most * this->bsize * this->width]();
+		}
+
+		~Analysis()
+		{
+			stop();
+			delete [] scratch;
+		}
+
+		// realtime, if given, is applied by the worker to itself before the first block
+		void start(Realtime* realtime = NULL)
+		{
+			if (running)
+				return;
+
+			running = true;
+			worker = std::thread([this, realtime]()
+			{
+				if (realtime)
+					realtime->enter();
+				work();
+			});
+		}
+
+		void stop()
+		{
+			running = false;
+			if (worker.joinable())
+				worker.join();
+		}
+
+		// audio callback: queue frames whose starts are stride items apart, e.g.
+		// one channel (width 1) of interleaved input; never blocks. frames go in
+		// whole or not at all, so the queue never loses its alignment
+		void push(const T* in, int frames, int stride = 1)
+		{
+			if (stride == width)
+			{
+				put(in, frames);
+				return;
+			}
+
+			T chunk[64];
+			int fit = std::max(1, 64 / width); // frames per chunk
+			for (int start = 0; start < frames; start += fit)
+			{
+				int n = std::min(fit, frames - start);
+				if (width > 64)
+				{
+					put(in + stride * start, 1);
+					continue;
+				}
+
+				for (int i = 0; i < n; i++)
+					for (int c = 0; c < width; c++)
+						chunk[width * i + c] = in[stride * (start + i) + c];
+				put(chunk, n);
+			}
+		}
+
+		// blocks analyzed, and how many of them were late
+		long blocks() const
+		{ return analyzed.load(std::memory_order_relaxed); }
+
+		long late() const
+		{ return overdue.load(std::memory_order_relaxed); }
+
+		// blocks skipped by the drop policy
+		long dropped() const
+		{ return skipped.load(std::memory_order_relaxed); }
+
+		// frames lost because the queue itself was full
+		long overruns() const
+		{ return lost.load(std::memory_order_relaxed); }
+
+		// mean and worst backlog behind a block, in seconds
+		double lateness() const
+		{ return blocks() ? behind.load(std::memory_order_relaxed) / blocks() : 0; }
+
+		double worst() const
+		{ return furthest.load(std::memory_order_relaxed); }
+
+		// seconds of work per second of audio analyzed; above 1, this thread
+		// can't keep up at full quality
+		double load() const
+		{
+			double audio = (double)covered.load(std::memory_order_relaxed) / SR;
+			return audio > 0 ? busy.load(std::memory_order_relaxed) / audio : 0;
+		}
+
+		// the current degradation level and decimation factor
+		int level() const
+		{ return depth.load(std::memory_order_relaxed); }
+
+		int factor() const
+		{ return stride.load(std::memory_order_relaxed); }
+
+	private:
+		static const int most = 8; // largest decimation factor
+
+		Stage stage;
+		int bsize;
+		Policy policy;
+		double deadline;
+		int levels;
+		int width; // items per frame
+
+		Ring<T> queue;
+		T* scratch;
+		std::atomic<long> lost{0};
+
+		std::thread worker;
+		std::atomic<bool> running{false};
+
+		// written by the worker only
+		std::atomic<long> analyzed{0};
+		std::atomic<long> overdue{0};
+		std::atomic<long> skipped{0};
+		std::atomic<long> covered{0}; // frames of audio analyzed, decimated or not
+		std::atomic<double> behind{0};
+		std::atomic<double> furthest{0};
+		std::atomic<double> busy{0};
+		std::atomic<int> depth{0};
+		std::atomic<int> stride{1};
+
+		void work()
+		{
+			while (running.load(std::memory_order_relaxed))
+			{
+				if (!queue.wait(bsize * width, 20))
+					continue;
+
+				int backlog = queue.available() / width - bsize;
+				double lag = (double)backlog / SR;
+				int factor = stride.load(std::memory_order_relaxed);
+				int level = depth.load(std::memory_order_relaxed);
+
+				if (lag > deadline)
+				{
+					overdue.fetch_add(1, std::memory_order_relaxed);
+					switch (policy)
+					{
+						case drop:
+						{
+							int excess = backlog - backlog % bsize;
+							queue.skip(excess * width);
+							skipped.fetch_add(excess / bsize, std::memory_order_relaxed);
+							break;
+						}
+						case decimate:
+							factor = std::min(most, 2 * factor);
+							break;
+						case degrade:
+							level = std::min(levels - 1, level + 1);
+							break;
+					}
+				}
+				else if (lag < deadline / 4)
+				{
+					factor = std::max(1, factor / 2);
+					level = std::max(0, level - 1);
+				}
+
+				stride.store(factor, std::memory_order_relaxed);
+				depth.store(level, std::memory_order_relaxed);
+
+				// a decimated block covers factor blocks of audio, as far as they have arrived
+				int count = std::min(bsize * factor, queue.available() / width);
+				count -= count % factor;
+				queue.read(scratch, count * width);
+
+				auto start = std::chrono::steady_clock::now();
+				stage(scratch, count / factor, factor * width, level);
+				auto stop = std::chrono::steady_clock::now();
+
+				analyzed.fetch_add(1, std::memory_order_relaxed);
+				covered.fetch_add(count, std::memory_order_relaxed);
+				busy.store(busy.load(std::memory_order_relaxed) + std::chrono::duration<double>(stop - start).count(), std::memory_order_relaxed);
+				behind.store(behind.load(std::memory_order_relaxed) + lag, std::memory_order_relaxed);
+				furthest.store(std::max(furthest.load(std::memory_order_relaxed), lag), std::memory_order_relaxed);
+			}
+		}
+
+		// audio callback: queue whole frames, or count them as lost
+		void put(const T* items, int frames)
+		{
+			if (queue.space() < frames * width)
+			{
+				lost.fetch_add(frames, std::memory_order_relaxed);
+				return;
+			}
+			queue.write(items, frames * width);
+		}
+	};
+}
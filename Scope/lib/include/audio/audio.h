@@ -2,6 +2,10 @@
 #pragma once
 
 #include "includes.h"
+#include "timing.h"
+#include "offline.h"
+#include "synthetic.h"
+#include "realtime.h"
 
 namespace soundmath
 {
@@ -16,6 +20,11 @@ namespace soundmath
 		PaStreamParameters inParams, outParams;
 
 		int (*process)(const float*, float*);
+		PaTime time = 0; // stream time at which the current block's first input frame was captured
+		Timing timing; // per-callback durations, jitter and xruns
+		Realtime* realtime = NULL; // opt-in setup: startup() locks memory, the callback thread sets itself up on its first call
+		bool entered = false;
+		bool running = false; // whether a device stream is open
 
 		Audio(int (*processor)(const float* in, float* out), int bsize = def_bsize) : bsize(bsize)
 		{
@@ -125,14 +134,58 @@ namespace soundmath
 			}
 
 			clean(Pa_OpenStream(&stream, &inParams, &outParams, SR, bsize, 0, callback, this));
+			if (realtime)
+				realtime->prepare(); // memory locking is process-wide; the callback only does the per-thread part
+			timing.watch(stream);
 			clean(Pa_StartStream(stream));
+			running = true;
 		}
 
-		void shutdown()
+		// instead of startup(): run a WAV file ("-" for stdin) through process as
+		// fast as possible, until it ends or process returns non-zero. time counts
+		// from 0 in the file's frames. returns the real-time factor
+		double render(const std::string& path, int in = 1, int out = 2, bool report = true)
 		{
-			clean(Pa_StopStream(stream));
-			clean(Pa_CloseStream(stream));
-			clean(Pa_Terminate());
+			time = 0;
+			Offline offline([this](const float* input, float* output, unsigned long frames)
+			{
+				int result = process(input, output);
+				time += (double)frames / SR;
+				return result;
+			}, bsize, in, out);
+
+			return offline.run(path, &timing, report);
+		}
+
+		// instead of startup(): call process for seconds of a waveform (NULL for
+		// noise), at the device's cadence or free-running, until process returns
+		// non-zero. time counts from 0. returns the real-time factor
+		double simulate(Wave<double>* form, double seconds, int in = 1, int out = 2, bool paced = true, bool report = true)
+		{
+			time = 0;
+			Synthetic synthetic([this](const float* input, float* output, unsigned long frames)
+			{
+				int result = process(input, output);
+				time += (double)frames / SR;
+				return result;
+			}, form, 220, 0.5, 0, bsize, in, out);
+
+			return synthetic.run(seconds, paced, &timing, report);
+		}
+
+		// stops the stream, if any; if timings names a file, the callback statistics go there
+		void shutdown(const std::string& timings = "")
+		{
+			if (running)
+			{
+				clean(Pa_StopStream(stream));
+				clean(Pa_CloseStream(stream));
+				clean(Pa_Terminate());
+				running = false;
+			}
+
+			if (!timings.empty() && !timing.dump(timings))
+				std::cout << "couldn't write callback timings to " << timings << std::endl;
 		}
 	};
 
@@ -143,7 +196,16 @@ namespace soundmath
 				  void* userData)
 	{
 		Audio* A = (Audio*)userData;
+		if (A->realtime && !A->entered)
+		{
+			A->realtime->enter();
+			A->entered = true;
+		}
+
+		A->timing.begin(framesPerBuffer, statusFlags);
+		A->time = timeInfo->inputBufferAdcTime;
 		A->process((const float*) inputBuffer, (float*) outputBuffer);
+		A->timing.end();
 		return 0;
 	}
 }
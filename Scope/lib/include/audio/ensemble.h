@@ -0,0 +1,309 @@
+// ensemble.h
+#pragma once
+
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <numeric>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <climits>
+#elif defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#endif
+
+#include "includes.h"
+#include "subspace.h"
+
+namespace soundmath
+{
+	// several Subspace trackers (different delays, k, alpha, delta, mode) run in
+	// lockstep on one input, e.g. the four parameter sets of the videos. one
+	// history ring feeds one gather per sample, over the union of all the delay
+	// sets; each tracker reads its own rows of that block through learn(). when
+	// there are spare cores, trackers are dealt out to worker threads by their
+	// cost per sample, and the workers wake once per block, as a Ring's consumer
+	// does: a futex (or semaphore) call only when one is asleep, never a lock.
+	// add() is for setup; process() does not allocate.
+	template <typename T> class Ensemble
+	{
+		typedef typename Eigen::NumTraits<T>::Real Real;
+		typedef Eigen::Matrix<T, Dynamic, Dynamic> Block;
+
+	public:
+		// threads < 0 uses as many cores as the trackers keep busy: no more than
+		// the costliest tracker's share of the total allows for; 1 runs everything
+		// in the caller's thread. idle workers spin (yielding) for spin
+		// microseconds after a block, in case the next one follows closely, and
+		// then sleep until it arrives
+		Ensemble(int bsize = 64, int threads = -1, int spin = 50) :
+			bsize(std::max(1, bsize)), threads(threads), spin(spin)
+		{
+#ifdef __APPLE__
+			semaphore = dispatch_semaphore_create(0);
+#endif
+		}
+
+		~Ensemble()
+		{
+			stop();
+#ifdef __APPLE__
+			dispatch_release(semaphore);
+#endif
+		}
+
+		// add a tracker; takes the remaining Subspace constructor arguments after
+		// delays and k. returns its index
+		template <typename... Args> int add(const std::vector<uint>& delays, int k, Args... args)
+		{
+			stop();
+
+			trackers.push_back(std::make_unique<Subspace<T>>(delays, k, args...));
+			lags.push_back(delays);
+			trajectories.push_back(std::vector<T>(k * bsize));
+			distances.push_back(std::vector<Real>(bsize));
+
+			// the union of every delay set, and each tracker's rows within it
+			all.clear();
+			for (const std::vector<uint>& set : lags)
+				all.insert(all.end(), set.begin(), set.end());
+			std::sort(all.begin(), all.end());
+			all.erase(std::unique(all.begin(), all.end()), all.end());
+
+			rows.clear();
+			for (const std::vector<uint>& set : lags)
+			{
+				std::vector<int> indices;
+				for (uint delay : set)
+					indices.push_back(std::lower_bound(all.begin(), all.end(), delay) - all.begin());
+				rows.push_back(indices);
+			}
+
+			width = all.back() + 1;
+			history.assign(2 * width, T(0)); // allows for circular buffering without modulo
+			origin = 0;
+			gathered.setZero(all.size(), bsize);
+
+			start();
+			return trackers.size() - 1;
+		}
+
+		// run a block of (possibly interleaved) input through every tracker. the
+		// per-tracker outputs hold the last bsize frames (all of them if frames
+		// <= bsize)
+		void process(const float* in, int frames, int stride = 1)
+		{
+			for (int start = 0; start < frames; start += bsize)
+			{
+				m = std::min(bsize, frames - start);
+
+				for (int i = 0; i < m; i++)
+				{
+					history[origin] = analytic(in[stride * (start + i)]);
+					history[origin + width] = history[origin];
+
+					for (int j = 0; j < (int)all.size(); j++)
+						gathered(j, i) = history[origin + all[j]];
+
+					origin--;
+					if (origin < 0)
+						origin += width;
+				}
+
+				pending.store(workers.size(), std::memory_order_relaxed);
+				generation.fetch_add(1); // seq_cst, against the sleepers count in await()
+				if (sleepers.load() > 0)
+					wake();
+
+				run(0);
+
+				while (pending.load(std::memory_order_acquire) > 0)
+					std::this_thread::yield();
+			}
+		}
+
+		Subspace<T>& operator[](int i)
+		{ return *trackers[i]; }
+
+		int size() const
+		{ return trackers.size(); }
+
+		// the last block's k x frames trajectory coordinates and distances of a tracker
+		const T* trajectory(int i) const
+		{ return trajectories[i].data(); }
+
+		const Real* distance(int i) const
+		{ return distances[i].data(); }
+
+		// the number of threads sharing the trackers, counting the caller's
+		int concurrency() const
+		{ return workers.size() + 1; }
+
+	private:
+		int bsize;
+		int threads;
+		int spin; // microseconds an idle worker polls before sleeping
+
+		std::vector<std::unique_ptr<Subspace<T>>> trackers;
+		std::vector<std::vector<uint>> lags; // each tracker's delays
+		std::vector<uint> all; // sorted union of the delays
+		std::vector<std::vector<int>> rows; // each tracker's delays, as rows of gathered
+		std::vector<std::vector<T>> trajectories;
+		std::vector<std::vector<Real>> distances;
+
+		std::vector<T> history;
+		int width = 0;
+		int origin = 0;
+		Block gathered; // all.size() x bsize embeddings of the current block
+		int m = 0; // frames in the current block
+
+		std::vector<std::vector<int>> assigned; // the trackers each thread runs; 0 is the caller
+		std::vector<std::thread> workers;
+		std::atomic<uint> generation{0}; // bumped for every block
+		std::atomic<int> pending{0}; // workers yet to finish the current block
+		std::atomic<bool> running{false};
+		std::atomic<int> sleepers{0};
+
+#ifdef __APPLE__
+		dispatch_semaphore_t semaphore;
+#endif
+
+		Hilbert<Real> hilbert;
+
+		T analytic(float sample)
+		{
+			if constexpr (Eigen::NumTraits<T>::IsComplex)
+			{
+				T z = hilbert(sample);
+				hilbert.tick();
+				return z;
+			}
+			else
+				return sample;
+		}
+
+		// rough multiply-adds per sample: B's rank-one update dominates qr and
+		// svd; past, gradient and the Toeplitz products are linear in N
+		static double cost(const Subspace<T>& tracker)
+		{
+			double N = tracker.dimension(), k = tracker.rank();
+			switch (tracker.tracking())
+			{
+				case Tracking::qr:
+				case Tracking::svd:
+					return N * (N + k);
+				default:
+					return N * (k + 1);
+			}
+		}
+
+		void run(int w)
+		{
+			for (int i : assigned[w])
+				trackers[i]->learn(gathered(rows[i], Eigen::seqN(0, m)), trajectories[i].data(), distances[i].data());
+		}
+
+		// wait for the generation to move past seen, or for stop(); returns the new generation
+		uint await(uint seen)
+		{
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(spin);
+			while (generation.load(std::memory_order_acquire) == seen && running.load(std::memory_order_relaxed))
+			{
+				if (std::chrono::steady_clock::now() < deadline)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				sleepers.fetch_add(1); // seq_cst, against the generation bump in process()
+				sleep(seen);
+				sleepers.fetch_sub(1);
+			}
+			return generation.load(std::memory_order_acquire);
+		}
+
+		// wake every sleeping worker
+		void wake()
+		{
+#ifdef __linux__
+			syscall(SYS_futex, (uint32_t*)&generation, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#elif defined(__APPLE__)
+			for (int i = sleepers.load(); i > 0; i--)
+				dispatch_semaphore_signal(semaphore);
+#endif
+		}
+
+		// sleep while generation == seen; may return early
+		void sleep(uint seen)
+		{
+#ifdef __linux__
+			syscall(SYS_futex, (uint32_t*)&generation, FUTEX_WAIT_PRIVATE, seen, NULL, NULL, 0);
+#elif defined(__APPLE__)
+			if (generation.load() == seen) // a bump after this finds the sleeper counted, and signals
+				dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+#else
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+#endif
+		}
+
+		// deal the trackers out, costliest first, each to the least loaded thread
+		void start()
+		{
+			std::vector<double> costs;
+			double total = 0, most = 0;
+			for (const std::unique_ptr<Subspace<T>>& tracker : trackers)
+			{
+				costs.push_back(cost(*tracker));
+				total += costs.back();
+				most = std::max(most, costs.back());
+			}
+
+			int cores = std::max(1u, std::thread::hardware_concurrency());
+			int count = (threads < 0) ? std::min<int>(cores, most > 0 ? ceil(total / most) : 1) : threads;
+			count = std::max(1, std::min<int>(count, trackers.size()));
+
+			std::vector<int> order(trackers.size());
+			std::iota(order.begin(), order.end(), 0);
+			std::stable_sort(order.begin(), order.end(), [&costs](int a, int b) { return costs[a] > costs[b]; });
+
+			assigned.assign(count, std::vector<int>());
+			std::vector<double> loads(count, 0);
+			for (int i : order)
+			{
+				int w = std::min_element(loads.begin(), loads.end()) - loads.begin();
+				assigned[w].push_back(i);
+				loads[w] += costs[i];
+			}
+
+			running = true;
+			uint seen = generation.load();
+			for (int w = 1; w < count; w++)
+				workers.push_back(std::thread([this, w, seen]() mutable
+				{
+					while (true)
+					{
+						seen = await(seen);
+						if (!running.load(std::memory_order_relaxed))
+							return;
+
+						run(w);
+						pending.fetch_sub(1, std::memory_order_release);
+					}
+				}));
+		}
+
+		void stop()
+		{
+			running = false;
+			generation.fetch_add(1); // sleepers wait on the generation; move it so none goes back to sleep
+			wake();
+
+			for (std::thread& worker : workers)
+				worker.join();
+			workers.clear();
+		}
+	};
+}
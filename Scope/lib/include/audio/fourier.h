@@ -155,6 +155,83 @@ namespace soundmath
 	};
 
 
+	// products with an N x N symmetric Toeplitz matrix, given by its first column,
+	// through a circulant embedding of size L >= 2N - 1 and real FFTs: O(N log N)
+	// per product instead of O(N^2). the column's spectrum is computed once by
+	// column() and shared by every following product.
+	class Toeplitz
+	{
+	public:
+		Toeplitz(int N) : N(N), L(1)
+		{
+			while (L < 2 * N - 1)
+				L *= 2;
+
+			time = (double*) fftw_malloc(sizeof(double) * L);
+			freq = (std::complex<double>*) fftw_malloc(sizeof(std::complex<double>) * (L / 2 + 1));
+			spectrum = (std::complex<double>*) fftw_malloc(sizeof(std::complex<double>) * (L / 2 + 1));
+
+			forward = fftw_plan_dft_r2c_1d(L, time, reinterpret_cast<fftw_complex*>(freq), FFTW_MEASURE);
+			backward = fftw_plan_dft_c2r_1d(L, reinterpret_cast<fftw_complex*>(freq), time, FFTW_MEASURE);
+
+			memset(time, 0, sizeof(double) * L);
+			std::fill(spectrum, spectrum + L / 2 + 1, 0);
+		}
+
+		// owns fftw plans and buffers
+		Toeplitz(const Toeplitz&) = delete;
+		Toeplitz& operator=(const Toeplitz&) = delete;
+
+		~Toeplitz()
+		{
+			fftw_destroy_plan(forward);
+			fftw_destroy_plan(backward);
+			fftw_free(time); fftw_free(freq); fftw_free(spectrum);
+		}
+
+		// set the first column r_0, ..., r_{N-1}; the circulant's first column is
+		// r_0, ..., r_{N-1}, 0, ..., 0, r_{N-1}, ..., r_1
+		template <typename Column> void column(const Column& r)
+		{
+			memset(time, 0, sizeof(double) * L);
+			time[0] = r(0);
+			for (int i = 1; i < N; i++)
+				time[i] = time[L - i] = r(i);
+
+			fftw_execute(forward);
+			for (int i = 0; i < L / 2 + 1; i++)
+				spectrum[i] = freq[i] / (double)L; // fftw leaves the inverse unnormalized
+		}
+
+		// out = T in, for vectors of length N
+		template <typename In, typename Out> void operator()(const In& in, Out&& out)
+		{
+			for (int i = 0; i < N; i++)
+				time[i] = in(i);
+			memset(time + N, 0, sizeof(double) * (L - N));
+
+			fftw_execute(forward);
+			for (int i = 0; i < L / 2 + 1; i++)
+				freq[i] *= spectrum[i];
+			fftw_execute(backward);
+
+			for (int i = 0; i < N; i++)
+				out(i) = time[i];
+		}
+
+	private:
+		int N;
+		int L;
+
+		double* time;
+		std::complex<double>* freq;
+		std::complex<double>* spectrum;
+
+		fftw_plan forward;
+		fftw_plan backward;
+	};
+
+
 	class Cosine
 	{
 	public:
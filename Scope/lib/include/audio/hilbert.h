@@ -0,0 +1,81 @@
+// hilbert.h
+#pragma once
+
+#include "includes.h"
+
+namespace soundmath
+{
+	// streaming analytic signal x + i H[x] from two chains of allpass filters
+	// whose phase responses stay 90 degrees apart (to within about a degree)
+	// over all but the lowest and highest ~0.2% of the band; no lookahead, and
+	// one sample of latency. each stage is (a^2 - z^-2) / (1 - a^2 z^-2), with
+	// Olli Niemitalo's coefficients.
+	template <typename T> class Hilbert
+	{
+	public:
+		Hilbert()
+		{
+			const T real[4] = {0.6923878, 0.9360654322959, 0.9882295226860, 0.9987488452737};
+			const T imaginary[4] = {0.4021921162426, 0.8561710882420, 0.9722909545651, 0.9952884791278};
+
+			for (int i = 0; i < 4; i++)
+			{
+				squares[i] = real[i] * real[i];
+				squares[i + 4] = imaginary[i] * imaginary[i];
+			}
+
+			reset();
+		}
+
+		void reset()
+		{
+			memset(x, 0, sizeof(x));
+			memset(y, 0, sizeof(y));
+			late[0] = late[1] = 0;
+			computed = false;
+		}
+
+		std::complex<T> operator()(T sample)
+		{
+			if (!computed)
+			{
+				T re = sample, im = sample;
+				for (int i = 0; i < 4; i++)
+				{
+					x[i][0] = re;
+					re = y[i][0] = squares[i] * (re + y[i][2]) - x[i][2];
+
+					x[i + 4][0] = im;
+					im = y[i + 4][0] = squares[i + 4] * (im + y[i + 4][2]) - x[i + 4][2];
+				}
+
+				late[0] = re; // the real chain runs one sample ahead
+				value = std::complex<T>(late[1], -im); // positive frequencies turn counterclockwise
+				computed = true;
+			}
+
+			return value;
+		}
+
+		void tick()
+		{
+			for (int i = 0; i < 8; i++)
+			{
+				x[i][2] = x[i][1];
+				x[i][1] = x[i][0];
+				y[i][2] = y[i][1];
+				y[i][1] = y[i][0];
+			}
+			late[1] = late[0];
+			computed = false;
+		}
+
+	private:
+		T squares[8]; // stages 0-3 make the real part, 4-7 the imaginary part
+		T x[8][3]; // stage inputs, now and one and two samples ago
+		T y[8][3]; // stage outputs
+		T late[2];
+		std::complex<T> value;
+		bool computed;
+	};
+}
@@ -22,9 +22,10 @@ namespace soundmath
 
 	const double PI = 245850922.0 / 78256779.0;
 	const double E =  2.718281828459045;
-	// const int SR = 48000;
-	const int SR = 96000;
-	// const int SR = 192000;
+	// the engine's sample rate, e.g. 48000, 96000 or 192000. set it at startup,
+	// before constructing anything that depends on it; MAX_SR bounds it
+	inline int SR = 96000;
+	const int MAX_SR = 192000;
 	const int FORCE = 50000;
 	const double A4 = 440.0; // frequency of the A above middle C; tune if necessary
 
@@ -0,0 +1,110 @@
+// offline.h
+#pragma once
+
+#include <functional>
+#include <chrono>
+
+#include "includes.h"
+#include "wavreader.h"
+#include "timing.h"
+
+namespace soundmath
+{
+	// drives a process(in, out, frames) callback from a WAV file or stdin instead
+	// of a device, as fast as the cpu allows. blocks of bsize frames are laid out
+	// as in_chans interleaved channels (file channels repeat if the file has
+	// fewer); the output is discarded. as with a device callback, process
+	// returns non-zero (paComplete) to stop early. run() returns the real-time
+	// factor, i.e. seconds of audio processed per second of wall-clock time.
+	class Offline
+	{
+	public:
+		typedef std::function<int(const float* in, float* out, unsigned long frames)> Process;
+
+		Offline(Process process, int bsize = 64, int in_chans = 1, int out_chans = 1, int rate = SR)
+			: process(process), bsize(bsize), in_chans(in_chans), out_chans(out_chans), rate(rate)
+		{
+			in = new float[bsize * in_chans];
+			out = new float[bsize * out_chans];
+		}
+
+		~Offline()
+		{
+			delete [] in;
+			delete [] out;
+			delete [] raw;
+		}
+
+		// process the whole of path ("-" for stdin); timing, if given, sees every
+		// block as a callback. returns the real-time factor, or 0 if nothing could be read
+		double run(const std::string& path, Timing* timing = NULL, bool report = true)
+		{
+			WavReader reader(path, in_chans);
+			if (!reader.good())
+			{
+				std::cout << "Offline: couldn't read " << path << " as PCM or float WAV" << std::endl;
+				return 0;
+			}
+
+			int channels = reader.channelCount();
+			if (report && reader.sampleRate() != rate)
+				std::cout << path << ": " << reader.sampleRate() << " Hz file, processed as " << rate << " Hz" << std::endl;
+
+			delete [] raw;
+			raw = new float[bsize * channels];
+
+			frames = 0;
+			auto start = std::chrono::steady_clock::now();
+
+			int count;
+			while ((count = reader.read(raw, bsize)) > 0)
+			{
+				for (int i = 0; i < bsize; i++)
+					for (int c = 0; c < in_chans; c++)
+						in[in_chans * i + c] = (i < count) ? raw[channels * i + c % channels] : 0; // pad the last block
+
+				if (timing)
+					timing->begin(bsize, 0, false);
+				int result = process(in, out, bsize);
+				if (timing)
+					timing->end();
+
+				frames += count;
+				if (result != 0)
+					break;
+			}
+
+			seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			if (report)
+				std::cout << path << ": " << (double)frames / rate << " s of audio in " << seconds << " s, "
+						  << factor() << "x real time" << std::endl;
+
+			return factor();
+		}
+
+		// frames processed and wall-clock seconds taken by the last run()
+		long processed() const
+		{ return frames; }
+
+		double elapsed() const
+		{ return seconds; }
+
+		double factor() const
+		{ return seconds > 0 ? (double)frames / rate / seconds : 0; }
+
+	private:
+		Process process;
+		int bsize;
+		int in_chans;
+		int out_chans;
+		int rate;
+
+		float* in;
+		float* out;
+		float* raw = NULL; // interleaved frames as they come out of the file
+
+		long frames = 0;
+		double seconds = 0;
+	};
+}
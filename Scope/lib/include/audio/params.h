@@ -0,0 +1,156 @@
+// params.h
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+#include "includes.h"
+
+namespace soundmath
+{
+	// control values shared between control threads (keyboard, midi, osc) and
+	// the thread that uses them. writers stage values with set() and publish()
+	// them as one snapshot; the reader picks up the newest snapshot with
+	// update(), once per block, and never allocates, locks or sees a half-written
+	// one. the snapshots live in three slots that change hands with a single
+	// atomic exchange (a triple buffer), so neither side ever waits on the
+	// other. each parameter follows its target through a one-pole smoother,
+	// advanced for all parameters at once by tick() or advance().
+	class Parameters
+	{
+	public:
+		Parameters(int count) : count(count)
+		{
+			staging = new double[count]();
+			for (int i = 0; i < 3; i++)
+				slots[i] = new double[count]();
+
+			current = new double[count]();
+			rates = new double[count];
+			steps = new double[count];
+			for (int i = 0; i < count; i++)
+				rates[i] = steps[i] = 1;
+		}
+
+		~Parameters()
+		{
+			delete [] staging;
+			for (int i = 0; i < 3; i++)
+				delete [] slots[i];
+			delete [] current;
+			delete [] rates;
+			delete [] steps;
+		}
+
+		// per-tick coefficient for a smoother that covers 1 - 1/e of a jump in the given time
+		static double coefficient(double seconds, int rate = SR)
+		{ return seconds > 0 ? 1 - exp(-1.0 / (seconds * rate)) : 1; }
+
+		// how quickly a parameter follows its target, as a per-tick coefficient; 1
+		// (the default) jumps. set before the reader starts
+		void smoothing(int index, double coefficient)
+		{
+			rates[index] = coefficient;
+			span = 0;
+		}
+
+		// control threads: stage a value, and publish everything staged unless told to wait
+		void set(int index, double value, bool commit = true)
+		{
+			std::lock_guard<std::mutex> guard(writing);
+			staging[index] = value;
+			if (commit)
+				release();
+		}
+
+		void publish()
+		{
+			std::lock_guard<std::mutex> guard(writing);
+			release();
+		}
+
+		// control threads: the latest value staged, e.g. to step it
+		double staged(int index)
+		{
+			std::lock_guard<std::mutex> guard(writing);
+			return staging[index];
+		}
+
+		// reader, once per block: take the newest snapshot, if there is one
+		bool update()
+		{
+			if (!(shared.load(std::memory_order_relaxed) & fresh))
+				return false;
+
+			front = shared.exchange(front, std::memory_order_acq_rel) & ~fresh;
+			return true;
+		}
+
+		// reader: jump every parameter to its target, e.g. before the first block
+		void settle()
+		{
+			const double* target = slots[front];
+			for (int i = 0; i < count; i++)
+				current[i] = target[i];
+		}
+
+		// reader, per sample: move every parameter one step towards its target
+		void tick()
+		{
+			const double* target = slots[front];
+			for (int i = 0; i < count; i++)
+				current[i] += rates[i] * (target[i] - current[i]);
+		}
+
+		// reader: the same as frames calls to tick()
+		void advance(int frames)
+		{
+			if (frames != span)
+			{
+				for (int i = 0; i < count; i++)
+					steps[i] = 1 - pow(1 - rates[i], frames);
+				span = frames;
+			}
+
+			const double* target = slots[front];
+			for (int i = 0; i < count; i++)
+				current[i] += steps[i] * (target[i] - current[i]);
+		}
+
+		// reader: smoothed value and target
+		double operator[](int index) const
+		{ return current[index]; }
+
+		double target(int index) const
+		{ return slots[front][index]; }
+
+		int size() const
+		{ return count; }
+
+	private:
+		static const int fresh = 4; // marks a slot published since the reader last looked
+
+		int count;
+
+		// writers' side
+		std::mutex writing;
+		double* staging;
+		int back = 0;
+
+		double* slots[3];
+		std::atomic<int> shared{2};
+
+		// reader's side
+		int front = 1;
+		double* current;
+		double* rates;
+		double* steps; // rates compounded over span ticks
+		int span = 0;
+
+		void release()
+		{
+			memcpy(slots[back], staging, count * sizeof(double));
+			back = shared.exchange(back | fresh, std::memory_order_acq_rel) & ~fresh;
+		}
+	};
+}
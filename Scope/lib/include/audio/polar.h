@@ -0,0 +1,100 @@
+// polar.h
+#pragma once
+
+#include "includes.h"
+
+using Eigen::Matrix;
+
+namespace soundmath
+{
+	// kernels for the closest orthogonal matrix U to a small square M, i.e. the
+	// polar factor U V^T of M = U D V^T. none of them allocate, and the 2 x 2
+	// and 3 x 3 kernels have no data-dependent branches.
+
+	// for M = U P, M + sign(det M) cof(M) = tr(P) U; U is a rotation or a
+	// reflection according to the sign of det M
+	template <typename In, typename Out> void polar2(const In& M, Out& U)
+	{
+		typedef typename Out::Scalar T;
+
+		T a = M(0, 0), b = M(0, 1), c = M(1, 0), d = M(1, 1);
+		T s = std::copysign(T(1), a * d - b * c);
+
+		T x = a + s * d; // cos and sin of the rotation, up to tr(P)
+		T y = c - s * b;
+		T scale = 1 / std::sqrt(x * x + y * y + std::numeric_limits<T>::min());
+		x *= scale;
+		y *= scale;
+
+		U(0, 0) = x; U(0, 1) = -s * y;
+		U(1, 0) = y; U(1, 1) = s * x;
+	}
+
+	// determinant-scaled Newton iteration X <- (z X + (z X)^-T) / 2, with
+	// X^-T = cof(X) / det X; the fixed iteration count converges from any
+	// reasonably conditioned M, and in 2-3 steps from a near-rotation
+	template <typename In, typename Out> void polar3(const In& M, Out& U, int iterations = 6)
+	{
+		typedef typename Out::Scalar T;
+		Matrix<T, 3, 3> X = M;
+		Matrix<T, 3, 3> C;
+
+		for (int i = 0; i < iterations; i++)
+		{
+			C.col(0) = X.col(1).cross(X.col(2));
+			C.col(1) = X.col(2).cross(X.col(0));
+			C.col(2) = X.col(0).cross(X.col(1));
+
+			T det = X.col(0).dot(C.col(0));
+			det += std::copysign(std::numeric_limits<T>::min(), det);
+
+			T zeta = 1 / std::cbrt(std::abs(det)); // makes |det(z X)| = 1
+			X = (zeta * X + C / (zeta * det)) / 2;
+		}
+
+		U = X;
+	}
+
+	// general k: one-sided Jacobi sweeps from the warm start U (in/out), which
+	// should already be close to the answer, e.g. the previous sample's rotation.
+	// each plane rotation applies the 2 x 2 closed form to a pair of rows of
+	// H = U^T M, until H is symmetric and M = U H. H is scratch space.
+	// assumes det M has the sign of det U.
+	template <typename In, typename Out> void polar(const In& M, Out& U, Out& H, int sweeps = 2)
+	{
+		typedef typename Out::Scalar T;
+		int k = M.cols();
+
+		// keep the warm start from drifting off the orthogonal group
+		for (int j = 0; j < k; j++)
+		{
+			for (int i = 0; i < j; i++)
+				U.col(j) -= U.col(i).dot(U.col(j)) * U.col(i);
+			U.col(j).normalize();
+		}
+
+		H.noalias() = U.transpose() * M;
+
+		for (int sweep = 0; sweep < sweeps; sweep++)
+			for (int p = 0; p < k - 1; p++)
+				for (int q = p + 1; q < k; q++)
+				{
+					T x = H(p, p) + H(q, q);
+					T y = H(q, p) - H(p, q);
+					T scale = 1 / std::sqrt(x * x + y * y + std::numeric_limits<T>::min());
+					T c = x * scale;
+					T s = y * scale;
+
+					for (int j = 0; j < k; j++)
+					{
+						T hp = H(p, j), hq = H(q, j);
+						H(p, j) = c * hp + s * hq;
+						H(q, j) = c * hq - s * hp;
+
+						T up = U(j, p), uq = U(j, q);
+						U(j, p) = c * up + s * uq;
+						U(j, q) = c * uq - s * up;
+					}
+				}
+	}
+}
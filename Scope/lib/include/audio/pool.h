@@ -0,0 +1,115 @@
+// pool.h
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "includes.h"
+
+namespace soundmath
+{
+	// worker threads for jobs that come in batches, e.g. one per channel per
+	// video frame. run() hands out the indices of a batch one at a time, to the
+	// workers and the calling thread alike, so uneven jobs still balance, and
+	// returns once every one is done. idle workers sleep on a condition
+	// variable; that is cheap at frame rate, but not for the audio thread,
+	// which should use Ensemble, whose workers poll for a while before sleeping.
+	class Pool
+	{
+	public:
+		typedef std::function<void(int)> Job;
+
+		// threads < 0 uses every core; 1 runs everything in the caller's thread
+		Pool(int threads = -1)
+		{
+			int count = (threads < 0) ? std::max(1u, std::thread::hardware_concurrency()) : std::max(1, threads);
+			for (int w = 1; w < count; w++)
+				workers.push_back(std::thread([this]() { serve(); }));
+		}
+
+		~Pool()
+		{
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				running = false;
+			}
+			wake.notify_all();
+
+			for (std::thread& worker : workers)
+				worker.join();
+		}
+
+		// call job(i) for every i in [0, count), spread over the threads
+		void run(const Job& job, int count)
+		{
+			if (workers.empty() || count <= 1)
+			{
+				for (int i = 0; i < count; i++)
+					job(i);
+				return;
+			}
+
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				this->job = &job;
+				this->count = count;
+				next.store(0, std::memory_order_relaxed);
+				busy = workers.size();
+				generation++;
+			}
+			wake.notify_all();
+
+			work();
+
+			std::unique_lock<std::mutex> guard(lock);
+			done.wait(guard, [this]() { return busy == 0; });
+		}
+
+		// the number of threads sharing a batch, counting the caller's
+		int concurrency() const
+		{ return workers.size() + 1; }
+
+	private:
+		std::vector<std::thread> workers;
+		std::mutex lock;
+		std::condition_variable wake;
+		std::condition_variable done;
+
+		// the current batch; guarded by lock, except next
+		const Job* job = NULL;
+		int count = 0;
+		std::atomic<int> next{0};
+		int busy = 0; // workers yet to finish it
+		long generation = 0;
+		bool running = true;
+
+		void work()
+		{
+			for (int i = next.fetch_add(1, std::memory_order_relaxed); i < count; i = next.fetch_add(1, std::memory_order_relaxed))
+				(*job)(i);
+		}
+
+		void serve()
+		{
+			long seen = 0;
+			std::unique_lock<std::mutex> guard(lock);
+			while (true)
+			{
+				wake.wait(guard, [&]() { return generation != seen || !running; });
+				if (!running)
+					return;
+				seen = generation;
+
+				guard.unlock();
+				work();
+				guard.lock();
+
+				if (--busy == 0)
+					done.notify_one();
+			}
+		}
+	};
+}
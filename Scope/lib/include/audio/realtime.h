@@ -0,0 +1,147 @@
+// realtime.h
+#pragma once
+
+#include <cstring>
+#include <alloca.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <xmmintrin.h>
+#endif
+
+#include "includes.h"
+
+namespace soundmath
+{
+	// opt-in setup for a latency-critical thread (the audio callback, an
+	// Analysis worker). lock is process-wide and slow, so prepare() does it
+	// once, from the main thread, before the stream starts: every page mapped
+	// now or later stays resident, which also faults in the stacks of threads
+	// started afterwards, and the main thread's stack is touched. the rest is
+	// per thread and cheap, and enter() applies it from inside that thread:
+	// recursive filters ringing out into silence go denormal, which costs
+	// 10-100x per operation, so flush makes the cpu treat denormals as zero;
+	// priority asks for SCHED_FIFO, and core pins the thread. locking,
+	// priority and pinning usually need memlock and rtprio limits (see
+	// /etc/security/limits.conf), so a step that is refused is recorded rather
+	// than fatal; report() says which steps took.
+	class Realtime
+	{
+	public:
+		bool flush = true; // flush-to-zero and denormals-are-zero
+		int priority = 0; // SCHED_FIFO priority (1-99); 0 leaves scheduling alone
+		int core = -1; // cpu to run on; -1 leaves the thread free
+		bool lock = false; // mlockall in prepare()
+
+		Realtime() { }
+
+		Realtime(int priority, int core = -1, bool lock = true, bool flush = true)
+			: flush(flush), priority(priority), core(core), lock(lock)
+		{ }
+
+		// main thread, before starting the threads that need it: lock memory;
+		// returns whether that took
+		bool prepare()
+		{
+			locked = lock && resident();
+			return locked || !lock;
+		}
+
+		// set up the calling thread; returns whether every per-thread step took
+		bool enter()
+		{
+			flushed = flush && denormals();
+			scheduled = priority > 0 && schedule(priority);
+			pinned = core >= 0 && pin(core);
+
+			return (flushed || !flush) && (scheduled || priority <= 0) && (pinned || core < 0);
+		}
+
+		// undo prepare(), e.g. before measuring something else
+		void release()
+		{
+			if (locked)
+				munlockall();
+			locked = false;
+		}
+
+		void report(std::ostream& out) const
+		{
+			out << "real-time setup:";
+			if (flush)
+				out << " ftz/daz " << (flushed ? "on" : "unavailable") << ";";
+			if (priority > 0)
+				out << " SCHED_FIFO " << priority << (scheduled ? "" : " refused") << ";";
+			if (core >= 0)
+				out << " pinned to cpu " << core << (pinned ? "" : " refused") << ";";
+			if (lock)
+				out << " memory " << (locked ? "locked" : "lock refused") << ";";
+			out << std::endl;
+		}
+
+		// the steps, for threads that want to pick and choose
+
+		static bool denormals()
+		{
+#if defined(__x86_64__) || defined(__i386__)
+			_mm_setcsr(_mm_getcsr() | 0x8040); // FTZ (bit 15) and DAZ (bit 6)
+			return true;
+#elif defined(__aarch64__)
+			uint64_t fpcr;
+			asm volatile("mrs %0, fpcr" : "=r"(fpcr));
+			asm volatile("msr fpcr, %0" : : "r"(fpcr | (1 << 24))); // FZ covers both inputs and outputs
+			return true;
+#else
+			return false;
+#endif
+		}
+
+		static bool schedule(int priority)
+		{
+			sched_param parameters;
+			parameters.sched_priority = std::min(priority, sched_get_priority_max(SCHED_FIFO));
+			return pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters) == 0;
+		}
+
+		static bool pin(int core)
+		{
+#ifdef __linux__
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			CPU_SET(core, &cpus);
+			return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+			return false; // macOS only takes affinity hints
+#endif
+		}
+
+		// lock what is mapped now and later, and fault in some stack while it is cheap
+		static bool resident(size_t stack = 256 * 1024)
+		{
+			bool locked = mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+
+			volatile char* pages = (volatile char*)alloca(stack);
+			for (size_t i = 0; i < stack; i += 4096)
+				pages[i] = 0;
+
+			return locked;
+		}
+
+		// touch every page of a buffer, so that its first use doesn't fault; only
+		// needed for storage that was never written and memory that isn't locked
+		static void prefault(void* data, size_t bytes)
+		{
+			volatile char* pages = (volatile char*)data;
+			for (size_t i = 0; i < bytes; i += 4096)
+				pages[i] = pages[i];
+		}
+
+	private:
+		bool flushed = false;
+		bool scheduled = false;
+		bool pinned = false;
+		bool locked = false;
+	};
+}
@@ -0,0 +1,303 @@
+// recorder.h
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "includes.h"
+#include "ring.h"
+
+namespace soundmath
+{
+	// records interleaved blocks from the audio thread to a WAV file, as 32-bit
+	// float or packed 24-bit PCM. push() only copies into a ring (a block that
+	// doesn't fit is dropped whole, and counted); a background thread converts
+	// and writes 64 kB at a time through a buffered std::fstream, so the
+	// thread that blocks on the disk is never the audio thread. the header is
+	// brought up to date every refresh seconds (after the data it describes is
+	// flushed), so a file cut short by a crash still opens with everything up
+	// to the last fix-up. past 4 GB the file becomes RF64, using the space
+	// reserved for its ds64 chunk. float gets the fact chunk non-PCM formats
+	// need; 24-bit or more than two channels is WAVE_FORMAT_EXTENSIBLE.
+	class Recorder
+	{
+	public:
+		enum Format
+		{
+			float32,
+			pcm24
+		};
+
+		Recorder(const std::string& path, int channels, int rate = SR, Format format = float32, double buffered = 2, double refresh = 1)
+			: path(path), channels(channels), rate(rate), format(format), refresh(refresh)
+		{
+			width = (format == float32) ? 4 : 3;
+			ring = new Ring<float>(std::max(1.0, buffered * rate) * channels);
+			floats = new float[block / width + 1];
+			bytes = new char[block + width];
+		}
+
+		~Recorder()
+		{
+			stop();
+			delete ring;
+			delete [] floats;
+			delete [] bytes;
+		}
+
+		// open the file and start the writer; returns whether the file opened
+		bool start()
+		{
+			file.open(path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+			if (!file)
+			{
+				std::cout << "Recorder: couldn't open " << path << std::endl;
+				return false;
+			}
+
+			header();
+			running = true;
+			writer = std::thread([this]() { serve(); });
+			return true;
+		}
+
+		// write out what is left, finish the header and close the file. stop
+		// pushing first
+		void stop()
+		{
+			if (!running)
+				return;
+
+			running = false;
+			writer.join();
+
+			file.write(bytes, fill);
+			total += fill;
+			fill = 0;
+			if (total % 2)
+				file.put(0); // chunks are padded to even sizes
+
+			fix();
+			file.close();
+		}
+
+		// audio thread: record frames interleaved frames of channels each;
+		// returns false if the block was dropped
+		bool push(const float* in, int frames)
+		{
+			int count = frames * channels;
+			if (ring->space() < count)
+			{
+				lost.fetch_add(frames, std::memory_order_relaxed);
+				return false;
+			}
+
+			ring->write(in, count);
+			return true;
+		}
+
+		// frames on disk as of the last header fix-up, and frames dropped because
+		// the writer fell behind
+		long written() const
+		{ return frames.load(std::memory_order_relaxed); }
+
+		long dropped() const
+		{ return lost.load(std::memory_order_relaxed); }
+
+	private:
+		static const int block = 1 << 16; // bytes per write
+		static const int offset = 4096; // where the samples start
+
+		std::string path;
+		int channels;
+		int rate;
+		Format format;
+		double refresh;
+		int width; // bytes per sample
+
+		Ring<float>* ring;
+		std::thread writer;
+		std::atomic<bool> running{false};
+		std::atomic<long> frames{0};
+		std::atomic<long> lost{0};
+
+		// the writer's
+		std::fstream file;
+		std::streamoff fact = 0; // where the fact chunk's frame count is; 0 if there is none
+		float* floats;
+		char* bytes; // converted samples waiting for a full block
+		int fill = 0;
+		uint64_t total = 0; // bytes of samples written
+
+		void serve()
+		{
+			auto fixed = std::chrono::steady_clock::now();
+
+			while (running.load(std::memory_order_relaxed) || ring->available())
+			{
+				ring->wait(block / width, 50);
+
+				int count;
+				while ((count = std::min(ring->available(), (block - fill + width - 1) / width)) > 0)
+				{
+					ring->read(floats, count);
+					convert(floats, count);
+
+					if (fill >= block)
+					{
+						file.write(bytes, block);
+						total += block;
+						fill -= block;
+						memmove(bytes, bytes + block, fill);
+					}
+				}
+
+				if (std::chrono::steady_clock::now() - fixed > std::chrono::duration<double>(refresh))
+				{
+					fix();
+					fixed = std::chrono::steady_clock::now();
+				}
+			}
+		}
+
+		void convert(const float* in, int count)
+		{
+			if (format == float32)
+			{
+				memcpy(bytes + fill, in, count * sizeof(float));
+				fill += count * sizeof(float);
+				return;
+			}
+
+			for (int i = 0; i < count; i++)
+			{
+				int32_t value = lrint(std::max(-1.0f, std::min(1.0f, in[i])) * 8388607);
+				bytes[fill++] = value & 0xFF;
+				bytes[fill++] = (value >> 8) & 0xFF;
+				bytes[fill++] = (value >> 16) & 0xFF;
+			}
+		}
+
+		// RIFF, a chunk reserved for ds64, fmt, fact (float only), padding to
+		// offset, then data
+		void header()
+		{
+			bool extensible = format == pcm24 || channels > 2;
+			uint32_t sizes[] = { 0, 28, extensible ? 40u : (format == float32 ? 18u : 16u), 4 };
+			uint16_t tag = extensible ? 0xFFFE : (format == float32 ? 3 : 1);
+			uint16_t count = channels;
+			uint32_t frequency = rate;
+			uint32_t bytes_per_second = rate * channels * width;
+			uint16_t align = channels * width;
+			uint16_t bits = 8 * width;
+			char zeros[offset] = {};
+
+			file.write("RIFF", 4);
+			file.write((char*)&sizes[0], 4);
+			file.write("WAVE", 4);
+
+			file.write("JUNK", 4);
+			file.write((char*)&sizes[1], 4);
+			file.write(zeros, 28);
+
+			file.write("fmt ", 4);
+			file.write((char*)&sizes[2], 4);
+			file.write((char*)&tag, 2);
+			file.write((char*)&count, 2);
+			file.write((char*)&frequency, 4);
+			file.write((char*)&bytes_per_second, 4);
+			file.write((char*)&align, 2);
+			file.write((char*)&bits, 2);
+
+			if (extensible)
+			{
+				// every bit is valid; mono and stereo get the usual speakers, more
+				// channels none. the subformat is the plain tag in the KSDATAFORMAT GUID
+				uint16_t extra = 22;
+				uint32_t mask = (channels == 1) ? 0x4 : (channels == 2) ? 0x3 : 0;
+				uint16_t subformat = (format == float32) ? 3 : 1;
+				const unsigned char guid[14] = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+				file.write((char*)&extra, 2);
+				file.write((char*)&bits, 2);
+				file.write((char*)&mask, 4);
+				file.write((char*)&subformat, 2);
+				file.write((char*)guid, 14);
+			}
+			else if (format == float32)
+				file.write(zeros, 2); // no extension
+
+			if (format == float32)
+			{
+				file.write("fact", 4);
+				file.write((char*)&sizes[3], 4);
+				fact = file.tellp();
+				file.write(zeros, 4);
+			}
+
+			uint32_t padding = offset - 8 - (uint32_t)file.tellp() - 8;
+			file.write("JUNK", 4);
+			file.write((char*)&padding, 4);
+			file.write(zeros, padding);
+
+			file.write("data", 4);
+			file.write((char*)&sizes[0], 4);
+			file.flush();
+		}
+
+		// flush the samples, then make the header describe them
+		void fix()
+		{
+			file.flush();
+
+			uint64_t data = total - total % (channels * width);
+			uint64_t riff = offset - 8 + total + total % 2;
+			frames.store(data / (channels * width), std::memory_order_relaxed);
+
+			if (riff <= 0xFFFFFFFF)
+			{
+				uint32_t sizes[] = { (uint32_t)riff, (uint32_t)data };
+				file.seekp(4);
+				file.write((char*)&sizes[0], 4);
+				file.seekp(offset - 4);
+				file.write((char*)&sizes[1], 4);
+				if (fact)
+				{
+					uint32_t samples = data / (channels * width);
+					file.seekp(fact);
+					file.write((char*)&samples, 4);
+				}
+			}
+			else
+			{
+				uint32_t unknown = 0xFFFFFFFF;
+				uint32_t length = 28;
+				uint64_t samples = data / (channels * width);
+				uint32_t table = 0;
+
+				file.seekp(0);
+				file.write("RF64", 4);
+				file.write((char*)&unknown, 4);
+				file.seekp(12);
+				file.write("ds64", 4);
+				file.write((char*)&length, 4);
+				file.write((char*)&riff, 8);
+				file.write((char*)&data, 8);
+				file.write((char*)&samples, 8);
+				file.write((char*)&table, 4);
+				file.seekp(offset - 4);
+				file.write((char*)&unknown, 4);
+				if (fact)
+				{
+					file.seekp(fact);
+					file.write((char*)&unknown, 4); // the ds64 count stands in
+				}
+			}
+
+			file.seekp(0, std::ios::end);
+			file.flush();
+		}
+	};
+}
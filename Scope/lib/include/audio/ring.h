@@ -0,0 +1,196 @@
+// ring.h
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <ctime>
+#elif defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#endif
+
+#include "includes.h"
+
+namespace soundmath
+{
+	// wait-free single-producer, single-consumer ring, e.g. from the audio
+	// callback to the render loop. capacity is rounded up to a power of two so
+	// that indices wrap with a mask; the two indices live on separate cache
+	// lines. the consumer can sleep until enough items arrive; the producer
+	// only makes a (non-blocking) wake-up call when someone is waiting and the
+	// threshold has been reached. items that don't fit are dropped and counted
+	// as overruns; reads that come up short are counted as underruns.
+	template <typename T> class Ring
+	{
+	public:
+		Ring(uint capacity)
+		{
+			size = 1;
+			while (size < capacity)
+				size <<= 1;
+			mask = size - 1;
+
+			data = new T[size];
+			memset(data, 0, size * sizeof(T));
+
+#ifdef __APPLE__
+			semaphore = dispatch_semaphore_create(0);
+#endif
+		}
+
+		~Ring()
+		{
+			delete [] data;
+#ifdef __APPLE__
+			dispatch_release(semaphore);
+#endif
+		}
+
+		// producer: append up to count items; returns how many fit
+		int write(const T* items, int count)
+		{
+			uint back = tail.load(std::memory_order_relaxed);
+			if (back - seen_head + count > size)
+				seen_head = head.load(std::memory_order_acquire); // refresh only when needed
+
+			int room = size - (back - seen_head);
+			int n = std::min(count, room);
+			if (n < count)
+				dropped.fetch_add(count - n, std::memory_order_relaxed);
+
+			for (int i = 0; i < n; i++)
+				data[(back + i) & mask] = items[i];
+			tail.store(back + n, std::memory_order_release);
+
+			std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the fence in wait()
+			int wanted = threshold.load(std::memory_order_relaxed);
+			if (wanted > 0 && back + n - head.load(std::memory_order_relaxed) >= (uint)wanted)
+				wake();
+
+			return n;
+		}
+
+		// producer: room for this many items, e.g. to write a block whole or not at all
+		int space()
+		{
+			seen_head = head.load(std::memory_order_acquire);
+			return size - (tail.load(std::memory_order_relaxed) - seen_head);
+		}
+
+		// consumer: remove up to count items into items; returns how many there were
+		int read(T* items, int count)
+		{
+			uint front = head.load(std::memory_order_relaxed);
+			if (seen_tail - front < (uint)count)
+				seen_tail = tail.load(std::memory_order_acquire);
+
+			int n = std::min<int>(count, seen_tail - front);
+			if (n < count)
+				short_reads.fetch_add(1, std::memory_order_relaxed);
+
+			for (int i = 0; i < n; i++)
+				items[i] = data[(front + i) & mask];
+			head.store(front + n, std::memory_order_release);
+
+			return n;
+		}
+
+		// consumer: discard up to count of the oldest items; returns how many
+		int skip(int count)
+		{
+			uint front = head.load(std::memory_order_relaxed);
+			seen_tail = tail.load(std::memory_order_acquire); // read() must not fall behind head
+			int n = std::min<int>(count, seen_tail - front);
+			head.store(front + n, std::memory_order_release);
+			return n;
+		}
+
+		// consumer: items ready to read
+		int available() const
+		{
+			return tail.load(std::memory_order_acquire) - head.load(std::memory_order_relaxed);
+		}
+
+		// consumer: sleep until at least count items are ready, or until timeout
+		// milliseconds pass; returns whether they are ready
+		bool wait(int count, int timeout = 100)
+		{
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+			while (available() < count)
+			{
+				auto now = std::chrono::steady_clock::now();
+				if (now >= deadline)
+					return false;
+
+				uint generation = signals.load(std::memory_order_acquire);
+				threshold.store(count, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (available() < count) // the producer may have passed the threshold before seeing it
+					sleep(generation, std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count());
+				threshold.store(0, std::memory_order_relaxed);
+			}
+
+			return true;
+		}
+
+		// items dropped because the ring was full
+		long overruns() const
+		{ return dropped.load(std::memory_order_relaxed); }
+
+		// reads that found fewer items than they asked for
+		long underruns() const
+		{ return short_reads.load(std::memory_order_relaxed); }
+
+		int capacity() const
+		{ return size; }
+
+	private:
+		T* data;
+		uint size;
+		uint mask;
+
+		alignas(64) std::atomic<uint> head{0}; // next item to read; written by the consumer
+		uint seen_tail = 0; // the consumer's last look at tail
+
+		alignas(64) std::atomic<uint> tail{0}; // next slot to write; written by the producer
+		uint seen_head = 0; // the producer's last look at head
+
+		alignas(64) std::atomic<int> threshold{0}; // items the sleeping consumer waits for; 0 if awake
+		std::atomic<uint> signals{0}; // bumped by every wake-up
+		std::atomic<long> dropped{0};
+		std::atomic<long> short_reads{0};
+
+#ifdef __APPLE__
+		dispatch_semaphore_t semaphore;
+#endif
+
+		void wake()
+		{
+			signals.fetch_add(1, std::memory_order_release);
+#ifdef __linux__
+			syscall(SYS_futex, (uint32_t*)&signals, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#elif defined(__APPLE__)
+			dispatch_semaphore_signal(semaphore);
+#endif
+		}
+
+		// sleep while signals == generation, for at most the given microseconds
+		void sleep(uint generation, long microseconds)
+		{
+#ifdef __linux__
+			timespec timeout = { microseconds / 1000000, (microseconds % 1000000) * 1000 };
+			syscall(SYS_futex, (uint32_t*)&signals, FUTEX_WAIT_PRIVATE, generation, &timeout, NULL, 0);
+#elif defined(__APPLE__)
+			if (signals.load(std::memory_order_acquire) == generation)
+				dispatch_semaphore_wait(semaphore, dispatch_time(DISPATCH_TIME_NOW, microseconds * 1000));
+#else
+			std::this_thread::sleep_for(std::chrono::microseconds(std::min(microseconds, 1000L)));
+#endif
+		}
+	};
+}
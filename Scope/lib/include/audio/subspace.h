@@ -0,0 +1,643 @@
+// subspace.h
+#pragma once
+
+#include <memory>
+
+#include "includes.h"
+#include "polar.h"
+#include "fourier.h"
+#include "hilbert.h"
+
+using Eigen::Matrix;
+using Eigen::Dynamic;
+using Eigen::JacobiSVD;
+
+namespace soundmath
+{
+	// methods for returning the power step Z to an orthonormal basis;
+	// past skips the power step and runs an O(Nk) orthonormal PAST recursion;
+	// toeplitz is qr with B replaced by the running autocorrelation of a uniform
+	// delay ladder, so that B A costs k FFT products instead of O(N^2 k);
+	// gradient drops B too, and takes an O(Nk) stochastic gradient step along
+	// the Stiefel manifold with a Cayley retraction
+	enum Tracking
+	{
+		qr = 0, svd = 1, past = 2, toeplitz = 3, gradient = 4
+	};
+
+	// kernels for the closest rotation in the Procrustes correction: JacobiSVD,
+	// the branchless closed forms for k = 2 and 3, or warm-started Jacobi sweeps
+	enum Polar
+	{
+		exact = 0, closed = 1, jacobi = 2
+	};
+
+	// streaming delay-embedding subspace tracker; a port of Methods.analyze.
+	// each sample is embedded as y = (x[t - d_0], ..., x[t - d_{N-1}]) and folded
+	// into an exponentially forgotten covariance B; the N x k basis A follows
+	// the power step Z = (1 - delta) A + delta B A. all storage is claimed
+	// by the constructor, so operator(), process() and batch() never allocate.
+	// in past and gradient modes B is never formed and per-sample cost is O(Nk).
+	// Dim and Rank fix N and k at compile time, so that every per-sample matrix
+	// is a fixed-size Eigen type living inside the object and the small products,
+	// Gram-Schmidt and k x k decompositions unroll; Dynamic sizes are set by the
+	// constructor's delays and k. a tracker can be moved but not copied.
+	// T = float halves the memory traffic and doubles the SIMD lanes of every
+	// kernel; since float round-off slowly pulls A off the Stiefel manifold, the
+	// tracker watches |A^T A - I| and re-orthonormalizes in double when it
+	// exceeds a tolerance (see refine()).
+	// T = std::complex<float> or std::complex<double> tracks a complex subspace
+	// as in Methods.analyze(dtype = 'complex'): transposes become adjoints, and
+	// process() and batch() turn real input into the analytic signal with an
+	// allpass Hilbert pair, so an oscillator traces a circle in the trajectory.
+	// complex trackers use the exact Procrustes kernel and no toeplitz mode.
+	template <typename T, int Dim = Dynamic, int Rank = Dynamic> class Subspace
+	{
+		typedef Matrix<T, Dim, Dim> MatrixNN;
+		typedef Matrix<T, Dim, Rank> MatrixNK;
+		typedef Matrix<T, Rank, Rank> MatrixKK;
+		typedef Matrix<T, Dim, 1> VectorN;
+		typedef Matrix<T, Rank, 1> VectorK;
+
+		typedef Matrix<T, Dim, Dynamic> MatrixNB;
+		typedef Matrix<T, Rank, Dynamic> MatrixKB;
+		typedef typename Eigen::NumTraits<T>::Real Real;
+		typedef Matrix<Real, Dynamic, 1> VectorB;
+		typedef typename std::conditional<Eigen::NumTraits<T>::IsComplex, std::complex<double>, double>::type Double;
+
+	public:
+		Subspace(const std::vector<uint>& delays, int k, Real alpha = 0.99, Real delta = 0.01, Tracking mode = Tracking::qr,
+				 bool corrected = true, bool normalize = false, Real gamma = 0.01, bool randomize = true, int oversample = 1,
+				 int bsize = 64) :
+			N(delays.size()), k(k), alpha(alpha), delta(delta), gamma(gamma), mode(mode),
+			corrected(corrected), normalize(normalize), oversample(oversample), bsize(std::max(1, bsize)),
+			rotation(k, k, Eigen::ComputeFullU | Eigen::ComputeFullV)
+		{
+			assert(Dim == Dynamic || Dim == N);
+			assert(Rank == Dynamic || Rank == k);
+
+			this->delays = delays;
+
+			// toeplitz needs real samples and delays d_0 + i s
+			bool uniform = !Eigen::NumTraits<T>::IsComplex;
+			for (int i = 1; i < N; i++)
+				uniform = uniform && delays[i] > delays[i - 1] && delays[i] - delays[i - 1] == delays[1] - delays[0];
+
+			if (mode == Tracking::toeplitz && !uniform)
+			{
+				std::cout << "Subspace: toeplitz mode needs a real tracker and a uniform delay ladder; using qr.\n";
+				this->mode = mode = Tracking::qr;
+			}
+
+			width = *std::max_element(delays.begin(), delays.end()) + 1;
+			history.assign(2 * width, T(0)); // allows for circular buffering without modulo
+
+			y.setZero(N);
+			Z.setZero(N, k);
+			precise.setZero(N, k);
+			Q.setZero(N, k);
+			Y.setZero(k, k);
+			R.setZero(k, k);
+			S.setZero(k, k);
+			H.setZero(k, k);
+			trajectory.setZero(k);
+
+			if (mode == Tracking::past || mode == Tracking::gradient)
+			{
+				R.setIdentity(k, k);
+				q.setZero(k);
+			}
+			else
+			{
+				R.setIdentity(k, k); // warm starts for the Jacobi kernel
+				P.setIdentity(k, k);
+
+				if (mode == Tracking::toeplitz)
+				{
+					r.setZero(N);
+					products.reset(new Toeplitz(N));
+				}
+				else
+					B.setZero(N, N);
+
+				embeddings.setZero(N, this->bsize);
+				weighted.setZero(N, this->bsize);
+				projections.setZero(k, this->bsize);
+				energies.setZero(this->bsize);
+			}
+
+			A.setIdentity(N, k);
+			if (randomize)
+			{
+				for (int i = 0; i < N; i++)
+					for (int j = 0; j < k; j++)
+					{
+						A(i, j) = 2 * ((Real)rand() / RAND_MAX) - 1;
+						if constexpr (Eigen::NumTraits<T>::IsComplex)
+							A(i, j) += T(0, 2 * ((Real)rand() / RAND_MAX) - 1);
+					}
+				orthonormalize(A);
+			}
+
+			procrustes(k <= 3 ? Polar::closed : Polar::jacobi);
+			refine(std::is_same<Real, float>::value ? 1e-4 : 0);
+		}
+
+		// embed a sample and update the basis; returns the k coordinates of the
+		// sample's projection onto the learned subspace
+		const VectorK& operator()(T sample)
+		{
+			if (!computed)
+			{
+				history[origin] = sample;
+				history[origin + width] = sample;
+
+				for (int i = 0; i < N; i++)
+					y(i) = history[origin + delays[i]];
+
+				absorb();
+				computed = true;
+			}
+
+			return trajectory;
+		}
+
+		// timestep
+		void tick()
+		{
+			origin--;
+			if (origin < 0)
+				origin += width;
+			computed = false;
+		}
+
+		// run a block of (possibly interleaved) input through the tracker, writing
+		// frames x k trajectory coordinates and frames distances if requested
+		void process(const float* in, int frames, int stride = 1, T* trajectories = NULL, Real* distances = NULL)
+		{
+			for (int i = 0; i < frames; i++)
+			{
+				(*this)(analytic(in[stride * i]));
+
+				if (trajectories != NULL)
+					for (int j = 0; j < k; j++)
+						trajectories[k * i + j] = trajectory(j);
+				if (distances != NULL)
+					distances[i] = residual;
+
+				tick();
+			}
+		}
+
+		// block-batched process(): the embeddings of up to bsize samples are stacked
+		// into an N x bsize matrix, folded into B with one weighted rank-bsize update,
+		// and followed by a single power step and orthonormalization. every sample
+		// is still projected, onto the basis learned at the end of its block.
+		void batch(const float* in, int frames, int stride = 1, T* trajectories = NULL, Real* distances = NULL)
+		{
+			if (mode == Tracking::past || mode == Tracking::gradient) // already O(Nk) per sample
+			{
+				process(in, frames, stride, trajectories, distances);
+				return;
+			}
+
+			for (int start = 0; start < frames; start += bsize)
+			{
+				int m = std::min(bsize, frames - start);
+				block(in + stride * start, m, stride,
+					  trajectories != NULL ? trajectories + k * start : NULL,
+					  distances != NULL ? distances + start : NULL);
+			}
+		}
+
+		// run precomputed embeddings (the columns of the N x frames Y) through the
+		// tracker as batch() would, bypassing its own history; this lets several
+		// trackers share one gather (see Ensemble)
+		template <typename Embeddings> void learn(const Embeddings& Y, T* trajectories = NULL, Real* distances = NULL)
+		{
+			int frames = Y.cols();
+
+			if (mode == Tracking::past || mode == Tracking::gradient)
+			{
+				for (int i = 0; i < frames; i++)
+				{
+					y = Y.col(i);
+					absorb();
+
+					if (trajectories != NULL)
+						for (int j = 0; j < k; j++)
+							trajectories[k * i + j] = trajectory(j);
+					if (distances != NULL)
+						distances[i] = residual;
+				}
+				return;
+			}
+
+			for (int start = 0; start < frames; start += bsize)
+			{
+				int m = std::min(bsize, frames - start);
+				embeddings.leftCols(m) = Y.middleCols(start, m);
+				fold(m, trajectories != NULL ? trajectories + k * start : NULL,
+					 distances != NULL ? distances + start : NULL);
+			}
+		}
+
+		// choose the kernel for closest rotations; closed is only available for
+		// k = 2 and 3, and falls back to jacobi otherwise. complex trackers
+		// always use exact
+		void procrustes(Polar kernel, int sweeps = 2)
+		{
+			this->kernel = (kernel == Polar::closed && k > 3) ? Polar::jacobi : kernel;
+			if (Eigen::NumTraits<T>::IsComplex)
+				this->kernel = Polar::exact;
+			this->sweeps = sweeps;
+		}
+
+		// re-orthonormalize A in double whenever |A^T A - I|_F exceeds tolerance;
+		// 0 turns the check off. on by default (1e-4) for float trackers
+		void refine(Real tolerance)
+		{ this->tolerance = tolerance; }
+
+		// |A^T A - I|_F at the last check, before any refinement
+		Real drift() const
+		{ return deviation; }
+
+		// number of double-precision re-orthonormalizations so far
+		long refinements() const
+		{ return refined; }
+
+		// N x k matrix with orthonormal columns
+		const MatrixNK& basis() const
+		{ return A; }
+
+		// the most recent embedding vector
+		const VectorN& embedding() const
+		{ return y; }
+
+		// squared distance from the most recent embedding to the learned subspace
+		Real distance() const
+		{ return residual; }
+
+		int dimension() const
+		{ return N; }
+
+		int rank() const
+		{ return k; }
+
+		Tracking tracking() const
+		{ return mode; }
+
+		// distance between the subspaces learned by this and another tracker:
+		// the Frobenius norm of the difference of their projections, over sqrt(2);
+		// the other tracker may be of either precision
+		template <typename Other> Real error(const Other& other) const
+		{
+			Real overlap = (A.adjoint() * other.basis().template cast<T>()).squaredNorm();
+			return sqrt(std::max<Real>(0, k - overlap));
+		}
+
+	private:
+		int N; // embedding dimension
+		int k; // subspace dimension
+		Real alpha; // covariance forgetting factor
+		Real delta; // power step size
+		Real gamma; // normalization regularizer
+		Tracking mode;
+		bool corrected; // rotate each new basis to be close to the old one
+		bool normalize; // weight embeddings by their inverse energy
+		int oversample; // power steps per sample
+		int bsize; // largest block handled at once by batch()
+		Polar kernel;
+		int sweeps; // Jacobi sweeps per closest rotation
+		Real tolerance; // largest |A^H A - I|_F before refinement in double
+		Real deviation = 0;
+		long refined = 0;
+		int unchecked = 0; // samples since the last drift check
+
+		std::vector<uint> delays;
+		std::vector<T> history;
+		int width;
+		int origin = 0;
+		bool computed = false;
+
+		VectorN y; // embedding
+		MatrixNN B; // covariance
+		VectorN r; // autocorrelation along a uniform ladder; B_ij ~ r_|i - j|
+		std::unique_ptr<Toeplitz> products;
+		MatrixNK A; // basis
+		Matrix<Double, Dim, Rank> precise; // A, during refinement
+		MatrixNK Z; // power step
+		MatrixNK Q; // orthonormalized power step
+		MatrixKK Y; // Q^T A; A^T A when checking drift
+		MatrixKK R; // closest rotation to Y; in past mode, the inverse projected covariance
+		MatrixKK S; // triangular factor of Z
+		MatrixKK P; // closest rotation to S
+		MatrixKK H; // scratch for the Jacobi kernel
+		VectorK trajectory; // A^T y
+		VectorK q; // past mode gain direction; in gradient mode, the weighted A^H y
+
+		MatrixNB embeddings; // N x bsize block of embeddings
+		MatrixNB weighted; // the same, scaled for the block covariance update
+		MatrixKB projections; // k x bsize block of trajectory coordinates
+		VectorB energies;
+		Real residual = 0;
+
+		JacobiSVD<MatrixKK> rotation;
+		Hilbert<Real> hilbert; // analytic signal front end for complex trackers
+
+		// real input as a sample for this tracker: unchanged for real T, and the
+		// analytic signal x + i H[x] for complex T
+		T analytic(float sample)
+		{
+			if constexpr (Eigen::NumTraits<T>::IsComplex)
+			{
+				T z = hilbert(sample);
+				hilbert.tick();
+				return z;
+			}
+			else
+				return sample;
+		}
+
+		// embed m samples of input, then fold them in
+		void block(const float* in, int m, int stride, T* trajectories, Real* distances)
+		{
+			for (int i = 0; i < m; i++)
+			{
+				history[origin] = analytic(in[stride * i]);
+				history[origin + width] = history[origin];
+
+				for (int j = 0; j < N; j++)
+					embeddings(j, i) = history[origin + delays[j]];
+
+				tick();
+			}
+
+			fold(m, trajectories, distances);
+		}
+
+		// fold the first m columns of embeddings into the covariance, take one
+		// power step, and project them onto the new basis
+		void fold(int m, T* trajectories, Real* distances)
+		{
+			for (int i = 0; i < m; i++)
+				energies(i) = embeddings.col(i).squaredNorm();
+
+			if (mode == Tracking::toeplitz)
+				for (int i = 0; i < m; i++)
+				{
+					Real weight = normalize ? (1 - alpha) / (gamma + energies(i)) : (1 - alpha);
+					r = alpha * r + (weight * embeddings(0, i)) * embeddings.col(i);
+				}
+			else
+			{
+				// sample i of m is forgotten m - 1 - i more times before the block ends
+				Real forgetting = 1;
+				for (int i = m - 1; i >= 0; i--)
+				{
+					Real weight = normalize ? (1 - alpha) / (gamma + energies(i)) : (1 - alpha);
+					weighted.col(i) = sqrt(forgetting * weight) * embeddings.col(i);
+					forgetting *= alpha;
+				}
+
+				B.template triangularView<Eigen::Lower>() *= forgetting;
+				B.template selfadjointView<Eigen::Lower>().rankUpdate(weighted.leftCols(m));
+			}
+
+			// one step whose (1 - delta) factor compounds the block's m steps
+			for (int j = 0; j < oversample; j++)
+				update(1 - pow(1 - delta, m));
+			settle();
+
+			if constexpr (Eigen::NumTraits<T>::IsComplex) // for k = 1, Eigen would copy a conjugated row
+				for (int i = 0; i < m; i++)
+					projections.col(i).noalias() = A.adjoint() * embeddings.col(i);
+			else
+				projections.leftCols(m).noalias() = A.adjoint() * embeddings.leftCols(m);
+			for (int i = 0; i < m; i++)
+			{
+				Real remainder = energies(i) - projections.col(i).squaredNorm();
+				if (normalize)
+					remainder /= gamma + energies(i);
+
+				if (trajectories != NULL)
+					for (int j = 0; j < k; j++)
+						trajectories[k * i + j] = projections(j, i);
+				if (distances != NULL)
+					distances[i] = remainder;
+			}
+
+			y = embeddings.col(m - 1);
+			trajectory = projections.col(m - 1);
+			residual = energies(m - 1) - trajectory.squaredNorm();
+			if (normalize)
+				residual /= gamma + energies(m - 1);
+		}
+
+		// per-sample update from the embedding in y; sets trajectory and residual
+		void absorb()
+		{
+			Real energy = y.squaredNorm();
+			Real weight = normalize ? (1 - alpha) / (gamma + energy) : (1 - alpha);
+
+			if (mode == Tracking::past)
+				project(normalize ? 1 / sqrt(gamma + energy) : 1);
+			else if (mode == Tracking::gradient)
+				for (int j = 0; j < oversample; j++)
+					descend(normalize ? 1 / sqrt(gamma + energy) : 1);
+			else
+			{
+				if (mode == Tracking::toeplitz)
+					r = alpha * r + (weight * y(0)) * y;
+				else
+				{
+					// only the lower triangle of B is maintained
+					B.template triangularView<Eigen::Lower>() *= alpha;
+					B.template selfadjointView<Eigen::Lower>().rankUpdate(y, weight);
+				}
+
+				for (int j = 0; j < oversample; j++)
+					update(delta);
+			}
+
+			// drift is slow; check about as often as batch() would
+			if (++unchecked >= bsize)
+				settle();
+
+			trajectory.noalias() = A.adjoint() * y;
+			residual = energy - trajectory.squaredNorm();
+			if (normalize)
+				residual /= gamma + energy;
+		}
+
+		void update(Real step)
+		{
+			// column by column, so large N never needs a GEMM workspace
+			Z.noalias() = (1 - step) * A;
+			if constexpr (!Eigen::NumTraits<T>::IsComplex)
+				if (mode == Tracking::toeplitz)
+				{
+					products->column(r);
+					for (int j = 0; j < k; j++)
+					{
+						(*products)(A.col(j), Q.col(j));
+						Z.col(j) += step * Q.col(j);
+					}
+				}
+
+			if (mode != Tracking::toeplitz)
+				for (int j = 0; j < k; j++)
+					Z.col(j).noalias() += step * (B.template selfadjointView<Eigen::Lower>() * A.col(j));
+
+			Q = Z;
+			orthonormalize(Q);
+
+			if (mode == Tracking::svd)
+			{
+				// the closest orthonormal matrix to Z = QS is Q times the closest
+				// rotation to S; only a k x k SVD is needed
+				S.noalias() = Q.adjoint() * Z;
+				nearest(S, P);
+				Z.noalias() = Q * P;
+				Q = Z;
+			}
+
+			if (corrected)
+			{
+				// if Q and A have similar images, Y is close to a rotation
+				Y.noalias() = Q.adjoint() * A;
+				nearest(Y, R);
+
+				// spin Q so that it is close to the old A
+				A.noalias() = Q * R;
+			}
+			else
+				A = Q;
+		}
+
+		// measure the drift of A from orthonormality and repair it if needed;
+		// k^2 N flops, once per block
+		void settle()
+		{
+			unchecked = 0;
+			if (tolerance <= 0)
+				return;
+
+			Y.noalias() = A.adjoint() * A;
+			Y.diagonal().array() -= 1;
+			deviation = Y.norm();
+
+			if (deviation > tolerance)
+			{
+				precise = A.template cast<Double>();
+				orthonormalize(precise);
+				orthonormalize(precise); // twice is enough (Giraud et al.)
+				A = precise.template cast<T>();
+				refined++;
+			}
+		}
+
+		// closest orthogonal matrix to M (the polar factor U V^T of M = U D V^T);
+		// U holds the previous answer, which warm-starts the Jacobi kernel
+		void nearest(const MatrixKK& M, MatrixKK& U)
+		{
+			if constexpr (!Eigen::NumTraits<T>::IsComplex)
+			{
+				if (kernel == Polar::closed)
+				{
+					if constexpr (Rank == 2 || Rank == Dynamic)
+						if (k == 2)
+						{
+							polar2(M, U);
+							return;
+						}
+					if constexpr (Rank == 3 || Rank == Dynamic)
+						if (k == 3)
+						{
+							polar3(M, U);
+							return;
+						}
+				}
+
+				if (kernel == Polar::jacobi)
+				{
+					polar(M, U, H, sweeps);
+					return;
+				}
+			}
+
+			rotation.compute(M);
+			U.noalias() = rotation.matrixU() * rotation.matrixV().adjoint();
+		}
+
+		// orthonormal PAST (Abed-Meraim, Chkeif, Hua 2000) step with forgetting factor
+		// alpha, on the embedding scaled by the given weight; A stays orthonormal
+		void project(Real weight)
+		{
+			// don't let R forget its way to overflow during silence
+			Real forget = (std::real(R.trace()) < k / ((1 - alpha) * std::numeric_limits<Real>::epsilon())) ? 1 / alpha : 1;
+
+			trajectory.noalias() = weight * (A.adjoint() * y);
+			q.noalias() = forget * (R * trajectory);
+
+			Real g = 1 / (1 + std::real(trajectory.dot(q)));
+
+			// Z's first column holds p = g (weight y - A h)
+			Z.col(0).noalias() = weight * y;
+			Z.col(0).noalias() -= A * trajectory;
+			Z.col(0) *= g;
+
+			R *= forget;
+			R.noalias() -= g * q * q.adjoint();
+			R.template triangularView<Eigen::StrictlyUpper>() = R.adjoint(); // OPAST diverges if R drifts from symmetric
+			if constexpr (Eigen::NumTraits<T>::IsComplex) // or, for complex T, if its diagonal picks up a phase
+				R.diagonal() = R.diagonal().real().template cast<T>();
+
+			Real qq = q.squaredNorm();
+			if (qq > 0)
+			{
+				Real tau = (1 / sqrt(1 + Z.col(0).squaredNorm() * qq) - 1) / qq;
+				Z.col(0) *= 1 + tau * qq;
+				Z.col(0).noalias() += tau * (A * q);
+				A.noalias() += Z.col(0) * q.adjoint();
+			}
+		}
+
+		// stochastic gradient step with a Cayley retraction, on the embedding scaled
+		// by the given weight. with h = A^H y and g = y - A h, the gradient of |h|^2
+		// off the span of A is G = delta g h^H, and the Cayley transform of the skew
+		// generator G A^H - A G^H moves A to (A (I - S) + G) (I + S)^-1, where
+		// S = G^H G / 4. for rank-one G, (I + S)^-1 is a Sherman-Morrison update:
+		// A += (delta g - 2 s A h) h^H / (1 + s |h|^2) with s = delta^2 |g|^2 / 4.
+		// A stays orthonormal up to round-off, with no QR or Procrustes step.
+		void descend(Real weight)
+		{
+			q.noalias() = weight * (A.adjoint() * y);
+
+			// Z's first column holds g, then the update direction
+			Z.col(0).noalias() = weight * y;
+			Z.col(0).noalias() -= A * q;
+
+			Real s = delta * delta * Z.col(0).squaredNorm() / 4;
+			Z.col(0) *= delta;
+			Z.col(0).noalias() -= (2 * s) * (A * q);
+			Z.col(0) /= 1 + s * q.squaredNorm();
+
+			A.noalias() += Z.col(0) * q.adjoint();
+		}
+
+		// in-place economic QR (modified Gram-Schmidt); keeps Q, discards R
+		template <typename Basis> static void orthonormalize(Basis& M)
+		{
+			for (int j = 0; j < M.cols(); j++)
+			{
+				for (int i = 0; i < j; i++)
+					M.col(j) -= M.col(i).dot(M.col(j)) * M.col(i);
+
+				auto length = M.col(j).norm();
+				if (length > 0)
+					M.col(j) /= length;
+			}
+		}
+	};
+}
@@ -0,0 +1,137 @@
+// synthetic.h
+#pragma once
+
+#include <functional>
+#include <chrono>
+#include <thread>
+
+#include "includes.h"
+#include "synth.h"
+#include "noise.h"
+#include "timing.h"
+
+namespace soundmath
+{
+	// a null device: drives a process(in, out, frames) callback with input from
+	// a Synth (saw, square, triangle, cycle, ...) plus optional Noise, either at
+	// the cadence of real hardware (one call every bsize / rate seconds, on an
+	// absolute schedule) or free-running. a paced callback that is still running
+	// when the next one is due counts as a deadline miss. the output is discarded;
+	// as with a device callback, process returns non-zero (paComplete) to stop early.
+	class Synthetic
+	{
+	public:
+		typedef std::function<int(const float* in, float* out, unsigned long frames)> Process;
+
+		// form NULL gives noise alone, at amplitude unless a noise level is given
+		Synthetic(Process process, Wave<double>* form = &cycle, double frequency = 220, double amplitude = 0.5, double noise = 0,
+				  int bsize = 64, int in_chans = 1, int out_chans = 1, int rate = SR)
+			: process(process), oscillator(form ? form : &cycle, frequency), form(form), amplitude(amplitude), level(noise),
+			  bsize(bsize), in_chans(in_chans), out_chans(out_chans), rate(rate)
+		{
+			if (!form && level == 0)
+				level = amplitude;
+
+			in = new float[bsize * in_chans];
+			out = new float[bsize * out_chans];
+		}
+
+		~Synthetic()
+		{
+			delete [] in;
+			delete [] out;
+		}
+
+		// call process for the given seconds of audio, paced like a device or as
+		// fast as possible; timing, if given, sees every call. returns the real-time factor
+		double run(double seconds, bool paced = true, Timing* timing = NULL, bool report = true)
+		{
+			typedef std::chrono::steady_clock Clock;
+
+			long blocks = (long)(seconds * rate / bsize);
+			double period = (double)bsize / rate;
+			missed = 0;
+			busy = 0;
+			frames = 0;
+
+			Clock::time_point start = Clock::now();
+			for (long b = 0; b < blocks; b++)
+			{
+				Clock::time_point due = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(b * period));
+				if (paced)
+					std::this_thread::sleep_until(due);
+
+				generate();
+
+				Clock::time_point before = Clock::now();
+				if (timing)
+					timing->begin(bsize, 0, paced);
+				int result = process(in, out, bsize);
+				if (timing)
+					timing->end();
+				Clock::time_point after = Clock::now();
+
+				busy += std::chrono::duration<double>(after - before).count();
+				if (paced && after > due + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(period)))
+					missed++;
+				frames += bsize;
+				if (result != 0)
+					break;
+			}
+			elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+			if (report)
+				std::cout << "Synthetic: " << (double)frames / rate << " s of audio in " << elapsed << " s (" << factor()
+						  << "x real time), load " << load() << ", " << missed << " deadline misses" << std::endl;
+
+			return factor();
+		}
+
+		// paced calls that overran the next one's start
+		long misses() const
+		{ return missed; }
+
+		// time in process per second of audio
+		double load() const
+		{ return frames ? busy / ((double)frames / rate) : 0; }
+
+		double factor() const
+		{ return elapsed > 0 ? (double)frames / rate / elapsed : 0; }
+
+	private:
+		Process process;
+		Synth<double> oscillator;
+		Wave<double>* form;
+		Noise<double> noise;
+		double amplitude;
+		double level;
+
+		int bsize;
+		int in_chans;
+		int out_chans;
+		int rate;
+
+		float* in;
+		float* out;
+
+		long missed = 0;
+		long frames = 0;
+		double busy = 0;
+		double elapsed = 0;
+
+		// the same signal on every input channel
+		void generate()
+		{
+			for (int i = 0; i < bsize; i++)
+			{
+				double value = level * noise();
+				if (form)
+					value += amplitude * oscillator();
+				oscillator.tick();
+
+				for (int c = 0; c < in_chans; c++)
+					in[in_chans * i + c] = value;
+			}
+		}
+	};
+}
@@ -0,0 +1,187 @@
+// timing.h
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
+
+#include "includes.h"
+
+namespace soundmath
+{
+	// per-callback health of an audio stream: how long each callback took (as a
+	// histogram), how regularly callbacks arrived, PortAudio's under/overflow
+	// flags and its cpu load estimate. watch() the stream once it is open;
+	// begin() and end() then bracket the work in the callback. they only touch
+	// preallocated atomics, so any thread can read the numbers while the stream
+	// runs, and print() or dump() them at shutdown.
+	class Timing
+	{
+	public:
+		static const int bins = 24; // bin i counts durations in [2^(i-1), 2^i) microseconds; bin 0 is under 1 us
+
+		Timing(int rate = SR) : rate(rate)
+		{ }
+
+		void watch(PaStream* stream)
+		{ this->stream = stream; }
+
+		// for a stream whose rate is chosen after construction
+		void sampleRate(int rate)
+		{ this->rate = rate; }
+
+		// audio thread, first thing in the callback; callbacks that aren't paced
+		// by a device (see offline.h) don't count towards jitter
+		void begin(unsigned long frames, PaStreamCallbackFlags flags, bool paced = true)
+		{
+			started = std::chrono::steady_clock::now();
+
+			if (paced && arrived != std::chrono::steady_clock::time_point())
+			{
+				double gap = std::chrono::duration<double>(started - arrived).count();
+				double jitter = gap - (double)period / rate;
+				add(squares, jitter * jitter);
+				most(jitters, std::abs(jitter));
+			}
+			arrived = started;
+			period = frames;
+
+			if (flags & paInputUnderflow)
+				input_underflows.fetch_add(1, std::memory_order_relaxed);
+			if (flags & paInputOverflow)
+				input_overflows.fetch_add(1, std::memory_order_relaxed);
+			if (flags & paOutputUnderflow)
+				output_underflows.fetch_add(1, std::memory_order_relaxed);
+			if (flags & paOutputOverflow)
+				output_overflows.fetch_add(1, std::memory_order_relaxed);
+			if (flags & paPrimingOutput)
+				primings.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// audio thread, last thing in the callback
+		void end()
+		{
+			double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+			int slot = 0;
+			for (double us = duration * 1e6; us >= 1 && slot < bins - 1; us /= 2)
+				slot++;
+			histogram[slot].fetch_add(1, std::memory_order_relaxed);
+
+			add(busy, duration);
+			most(longest, duration);
+
+			if (stream)
+			{
+				double cpu = Pa_GetStreamCpuLoad(stream);
+				load.store(cpu, std::memory_order_relaxed);
+				most(peak, cpu);
+			}
+
+			callbacks.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		long count() const
+		{ return callbacks.load(std::memory_order_relaxed); }
+
+		// mean and longest callback, in seconds
+		double mean() const
+		{ return count() ? busy.load(std::memory_order_relaxed) / count() : 0; }
+
+		double worst() const
+		{ return longest.load(std::memory_order_relaxed); }
+
+		// rms and largest deviation of the time between callbacks from one buffer's worth, in seconds
+		double jitter() const
+		{ return count() > 1 ? sqrt(squares.load(std::memory_order_relaxed) / (count() - 1)) : 0; }
+
+		double spike() const
+		{ return jitters.load(std::memory_order_relaxed); }
+
+		// PortAudio's latest and highest cpu load estimates
+		double cpu() const
+		{ return load.load(std::memory_order_relaxed); }
+
+		double peaked() const
+		{ return peak.load(std::memory_order_relaxed); }
+
+		// callbacks flagged with each PortAudio status bit
+		long inputUnderflows() const
+		{ return input_underflows.load(std::memory_order_relaxed); }
+
+		long inputOverflows() const
+		{ return input_overflows.load(std::memory_order_relaxed); }
+
+		long outputUnderflows() const
+		{ return output_underflows.load(std::memory_order_relaxed); }
+
+		long outputOverflows() const
+		{ return output_overflows.load(std::memory_order_relaxed); }
+
+		long xruns() const
+		{ return inputUnderflows() + inputOverflows() + outputUnderflows() + outputOverflows(); }
+
+		long bin(int i) const
+		{ return histogram[i].load(std::memory_order_relaxed); }
+
+		void print(std::ostream& out) const
+		{
+			out << "callbacks " << count() << "\n";
+			out << "duration mean " << 1e6 * mean() << " us, worst " << 1e6 * worst() << " us\n";
+			out << "jitter rms " << 1e6 * jitter() << " us, worst " << 1e6 * spike() << " us\n";
+			out << "cpu load last " << cpu() << ", peak " << peaked() << "\n";
+			out << "input underflows " << inputUnderflows() << ", overflows " << inputOverflows() << "\n";
+			out << "output underflows " << outputUnderflows() << ", overflows " << outputOverflows() << "\n";
+			out << "priming callbacks " << primings.load(std::memory_order_relaxed) << "\n";
+			out << "duration histogram (us: callbacks)\n";
+			for (int i = 0; i < bins; i++)
+				if (bin(i))
+					out << "  < " << (1l << i) << ": " << bin(i) << "\n";
+		}
+
+		// write print()'s report to a file; returns whether that worked
+		bool dump(const std::string& path) const
+		{
+			std::ofstream file(path);
+			if (!file)
+				return false;
+			print(file);
+			return (bool)file;
+		}
+
+	private:
+		int rate;
+		PaStream* stream = NULL;
+
+		// only the audio thread touches these
+		std::chrono::steady_clock::time_point started;
+		std::chrono::steady_clock::time_point arrived;
+		unsigned long period = 0; // frames in the previous callback
+
+		// written by the audio thread, read by anyone
+		std::atomic<long> callbacks{0};
+		std::atomic<long> histogram[bins] = {};
+		std::atomic<double> busy{0};
+		std::atomic<double> longest{0};
+		std::atomic<double> squares{0};
+		std::atomic<double> jitters{0};
+		std::atomic<double> load{0};
+		std::atomic<double> peak{0};
+		std::atomic<long> input_underflows{0};
+		std::atomic<long> input_overflows{0};
+		std::atomic<long> output_underflows{0};
+		std::atomic<long> output_overflows{0};
+		std::atomic<long> primings{0};
+
+		// single writer, so load-then-store is enough
+		static void add(std::atomic<double>& total, double x)
+		{ total.store(total.load(std::memory_order_relaxed) + x, std::memory_order_relaxed); }
+
+		static void most(std::atomic<double>& extreme, double x)
+		{
+			if (x > extreme.load(std::memory_order_relaxed))
+				extreme.store(x, std::memory_order_relaxed);
+		}
+	};
+}
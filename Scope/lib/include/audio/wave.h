@@ -139,13 +139,13 @@ namespace soundmath
 
 	};
 
-	Wave<double> saw([] (double phase) -> double { return 2 * phase - 1; }, Interp::linear);
-	Wave<double> triangle([] (double phase) -> double { return abs(fmod(4 * phase + 3, 4.0) - 2) - 1; }, Interp::linear);
-	Wave<double> square([] (double phase) -> double { return phase > 0.5 ? 1 : (phase < 0.5 ? -1 : 0); }, Interp::none);
-	Wave<double> phasor([] (double phase) -> double { return phase; }, Interp::linear);
+	inline Wave<double> saw([] (double phase) -> double { return 2 * phase - 1; }, Interp::linear);
+	inline Wave<double> triangle([] (double phase) -> double { return abs(fmod(4 * phase + 3, 4.0) - 2) - 1; }, Interp::linear);
+	inline Wave<double> square([] (double phase) -> double { return phase > 0.5 ? 1 : (phase < 0.5 ? -1 : 0); }, Interp::none);
+	inline Wave<double> phasor([] (double phase) -> double { return phase; }, Interp::linear);
 	// Wave<double> noise([] (double phase) -> double { return  2 * ((double)rand() / RAND_MAX) - 1; }, Interp::linear);
-	Wave<double> cycle([] (double phase) -> double { return sin(2 * PI * phase); });
-	Wave<double> hann([] (double phase) -> double { return 0.5 * (1 - cos(2 * PI * phase)); });
-	Wave<double> halfhann([] (double phase) -> double { return sqrt(0.5 * (1 - cos(2 * PI * phase))); });
-	Wave<double> limiter([] (double phase) -> double { return 2.0 / PI * atan(phase); }, Interp::linear, -100, 100, false);
+	inline Wave<double> cycle([] (double phase) -> double { return sin(2 * PI * phase); });
+	inline Wave<double> hann([] (double phase) -> double { return 0.5 * (1 - cos(2 * PI * phase)); });
+	inline Wave<double> halfhann([] (double phase) -> double { return sqrt(0.5 * (1 - cos(2 * PI * phase))); });
+	inline Wave<double> limiter([] (double phase) -> double { return 2.0 / PI * atan(phase); }, Interp::linear, -100, 100, false);
 }
@@ -55,7 +55,7 @@ namespace soundmath
 
             // Fix the data chunk header to contain the data size
             f.seekp( data_chunk_pos + 4 );
-            write_word( f, file_length - data_chunk_pos + 8 );
+            write_word( f, file_length - data_chunk_pos - 8, 4 );
 
             // Fix the file header to contain the proper RIFF chunk size, which is (file size - 8) bytes
             f.seekp( 0 + 4 );
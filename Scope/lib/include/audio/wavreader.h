@@ -0,0 +1,209 @@
+// wavreader.h
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <cstring>
+
+#include "includes.h"
+
+namespace soundmath
+{
+	// streams interleaved float frames out of a WAV or RF64 file (PCM 8, 16, 24 or 32
+	// bit, or float 32 or 64 bit), or out of stdin when the path is "-". the
+	// header is read front to back without seeking, so piped WAV works too
+	// (e.g. ffmpeg -i clip.mp4 -f wav -); stdin that doesn't start with a RIFF
+	// header is taken as raw 32-bit float frames with the given channel count.
+	class WavReader
+	{
+	public:
+		WavReader(const std::string& path, int channels = 1, int rate = SR) : channels(channels), rate(rate)
+		{
+			if (path == "-")
+				in = &std::cin;
+			else
+			{
+				file.open(path, std::ios::binary);
+				in = &file;
+			}
+
+			valid = (bool)*in && header();
+		}
+
+		~WavReader()
+		{ delete [] bytes; }
+
+		// false if the file couldn't be opened or its format isn't supported
+		bool good() const
+		{ return valid; }
+
+		int channelCount() const
+		{ return channels; }
+
+		int sampleRate() const
+		{ return rate; }
+
+		// read up to frames interleaved frames into out; returns how many were read (0 at the end)
+		int read(float* out, int frames)
+		{
+			if (!valid)
+				return 0;
+
+			long wanted = (long)frames * channels * width;
+			if (remaining >= 0)
+				wanted = std::min(wanted, remaining - remaining % (channels * width));
+
+			if (wanted > capacity)
+			{
+				delete [] bytes;
+				capacity = wanted;
+				bytes = new unsigned char[capacity];
+			}
+
+			long got = std::min<long>(pending, wanted);
+			memcpy(bytes, lead, got);
+			memmove(lead, lead + got, pending - got);
+			pending -= got;
+
+			in->read((char*)bytes + got, wanted - got);
+			got += in->gcount();
+			got -= got % (channels * width);
+			if (remaining >= 0)
+				remaining -= got;
+
+			int count = got / width;
+			for (int i = 0; i < count; i++)
+				out[i] = convert(bytes + i * width);
+
+			return count / channels;
+		}
+
+	private:
+		std::ifstream file;
+		std::istream* in;
+		bool valid = false;
+
+		int channels;
+		int rate;
+		int format = 3; // 1 for integer PCM, 3 for float
+		int width = 4; // bytes per sample
+		long remaining = -1; // bytes left in the data chunk; -1 if unknown (streamed)
+
+		unsigned char* bytes = NULL;
+		long capacity = 0;
+
+		char lead[4]; // raw bytes consumed while looking for a header
+		int pending = 0;
+
+		bool header()
+		{
+			char id[4];
+			uint32_t size;
+
+			in->read(id, 4);
+			if (!*in)
+				return false;
+
+			bool wide = !strncmp(id, "RF64", 4); // RIFF past 4 GB, with 64-bit sizes in a ds64 chunk
+			if (strncmp(id, "RIFF", 4) && !wide)
+			{
+				if (in != &std::cin)
+					return false;
+
+				// raw float frames; the four bytes already read are the first sample
+				memcpy(lead, id, 4);
+				pending = 4;
+				return true;
+			}
+
+			in->read((char*)&size, 4);
+			in->read(id, 4);
+			if (!*in || strncmp(id, "WAVE", 4))
+				return false;
+
+			int bits = 0;
+			uint64_t length = 0; // the data size from ds64
+			while (in->read(id, 4) && in->read((char*)&size, 4))
+			{
+				if (!strncmp(id, "fmt ", 4))
+				{
+					unsigned char fmt[40] = {};
+					in->read((char*)fmt, std::min<uint32_t>(size, 40));
+					skip(size - std::min<uint32_t>(size, 40) + (size & 1));
+
+					uint16_t tag, count, depth;
+					uint32_t frequency;
+					memcpy(&tag, fmt, 2);
+					memcpy(&count, fmt + 2, 2);
+					memcpy(&frequency, fmt + 4, 4);
+					memcpy(&depth, fmt + 14, 2);
+					if (tag == 0xFFFE && size >= 26) // extensible: the subformat's first two bytes are the real tag
+						memcpy(&tag, fmt + 24, 2);
+
+					format = tag;
+					channels = count;
+					rate = frequency;
+					bits = depth;
+				}
+				else if (wide && !strncmp(id, "ds64", 4))
+				{
+					unsigned char ds64[16] = {};
+					in->read((char*)ds64, std::min<uint32_t>(size, 16));
+					skip(size - std::min<uint32_t>(size, 16) + (size & 1));
+					memcpy(&length, ds64 + 8, 8);
+				}
+				else if (!strncmp(id, "data", 4))
+				{
+					width = bits / 8;
+					bool pcm = format == 1 && (bits == 8 || bits == 16 || bits == 24 || bits == 32);
+					bool floating = format == 3 && (bits == 32 || bits == 64);
+					if (channels == 0 || !(pcm || floating))
+						return false;
+
+					// streaming writers leave the size as 0 or 0xFFFFFFFF
+					if (wide && size == 0xFFFFFFFF)
+						remaining = length ? length : -1;
+					else
+						remaining = (size == 0 || size == 0xFFFFFFFF) ? -1 : size;
+					return true;
+				}
+				else
+					skip(size + (size & 1));
+			}
+
+			return false;
+		}
+
+		// forward-only, so that pipes work
+		void skip(long count)
+		{
+			char scrap[256];
+			while (count > 0 && in->read(scrap, std::min<long>(count, 256)))
+				count -= 256;
+		}
+
+		float convert(const unsigned char* sample) const
+		{
+			if (format == 3)
+			{
+				if (width == 8)
+				{
+					double value;
+					memcpy(&value, sample, 8);
+					return value;
+				}
+
+				float value;
+				memcpy(&value, sample, 4);
+				return value;
+			}
+
+			if (width == 1)
+				return (sample[0] - 128) / 128.0f; // 8-bit PCM is unsigned
+
+			int32_t integer = 0;
+			memcpy((char*)&integer + 4 - width, sample, width); // left-justify, keep the sign
+			return integer / 2147483648.0f;
+		}
+	};
+}
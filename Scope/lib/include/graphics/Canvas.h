@@ -0,0 +1,53 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <cstdio>
+#include "Surface.h"
+
+// draws what a RenderWindow draws (same calls, same coordinates) into an RGBA
+// buffer in memory, on the CPU, with no window, display or GL context: for
+// rendering video in batch on a headless machine. pixels are Uint32s with red
+// in the low byte: SDL_PIXELFORMAT_RGBA32, bytes r, g, b, a, on the
+// little-endian machines Scope builds for. triangles cover the pixels whose centres they
+// contain, top and left edges inclusive, so triangles sharing an edge never
+// blend a pixel twice; colours are interpolated across them like
+// SDL_RenderGeometry's. supports the five built-in blend modes; custom ones
+// fall back to SDL_BLENDMODE_BLEND. if given a file, display() appends each
+// frame to it raw, e.g. for ffmpeg -f rawvideo -pix_fmt rgba -s WxH -i -.
+// this is for batch work, not real time: a frame of Scope at 1920 x 1080
+// takes about 66 ms on one core with AVX2, twice that in the portable build,
+// for bench's two-tone input; the time goes with the pixels covered, from
+// 30 ms for a sine to 300 ms for noise (portable)
+class Canvas : public Surface
+{
+public:
+	Canvas(int width, int height, bool highDPI = false, FILE* output = NULL);
+	~Canvas();
+
+	void blend(SDL_BlendMode mode) override;
+	void clear() override;
+	int color(double r, double g, double b, double a = 1, bool clip = true) override;
+	int color(Color& color) override;
+	void line(float x1, float y1, float x2, float y2) override;
+	void curve(SDL_FPoint* points, int count) override;
+	void geometry(SDL_Vertex* vertices, int count) override;
+	void geometry(SDL_Vertex* vertices, int count, const int* indices, int icount) override;
+	void rectangle(SDL_Rect* rect) override;
+	void display() override;
+
+	// the frame so far, rows top to bottom, width() pixels each
+	const Uint32* pixels();
+	int width();
+	int height();
+
+private:
+	int columns, rows;
+	Uint32* buffer;
+	FILE* output;
+	SDL_BlendMode mode;
+
+	void batch(const SDL_Vertex* vertices, int count, const int* indices, int icount);
+	void triangle(const SDL_Vertex& a, const SDL_Vertex& b, const SDL_Vertex& c, int from, int to);
+	void span(Uint32* pixels, int count, const float* start, const float* step);
+	void dot(int x, int y);
+	void segment(float x1, float y1, float x2, float y2, bool skip);
+};
@@ -0,0 +1,269 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cmath>
+
+// how segment lengths are measured when finding normals; smoothing is added
+// as a third coordinate, so short segments don't blow up
+enum Smoothing
+{
+	constant,
+	L2,
+	L1,
+	L4,
+	LHalf,
+	LInf
+};
+
+template <Smoothing type> inline float norm(float x, float y, float smoothing)
+{
+	if constexpr (type == constant)
+		return 1;
+	else if constexpr (type == L2)
+		return sqrtf(smoothing * smoothing + x * x + y * y);
+	else if constexpr (type == L1)
+		return fabsf(smoothing) + fabsf(x) + fabsf(y);
+	else if constexpr (type == L4)
+		return powf(smoothing * smoothing * smoothing * smoothing + x * x * x * x + y * y * y * y, 0.25f);
+	else if constexpr (type == LHalf)
+		return powf(sqrtf(fabsf(smoothing)) + sqrtf(fabsf(x)) + sqrtf(fabsf(y)), 2);
+	else
+		return std::max(fabsf(smoothing), std::max(fabsf(x), fabsf(y)));
+}
+
+// wedges of directions from an anchor, one per ribbon edge: a chord from the
+// anchor in any of them passes within tolerance of every point admitted since
+// the anchor. each admitted point narrows its wedge by asin(tolerance /
+// distance) either side, so points far along a straight run barely constrain
+// it and curves close it quickly. a point that doubles back towards the anchor
+// is refused too, so that the chord covers every point end to end. the four
+// edges are handled side by side in flat arrays, which the compiler turns into
+// one vector of four
+struct Cones
+{
+	float ax[4], ay[4]; // the anchors
+	float lox[4], loy[4], hix[4], hiy[4]; // unit directions bounding the wedges, counterclockwise from lo to hi
+	float reach[4]; // distance of the farthest point admitted
+	float open[4]; // 1 until something far enough away constrains the wedge
+
+	void reset(const SDL_FPoint* anchors)
+	{
+		for (int e = 0; e < 4; e++)
+		{
+			ax[e] = anchors[e].x;
+			ay[e] = anchors[e].y;
+			reach[e] = 0;
+			open[e] = 1;
+		}
+	}
+
+	// whether the chords to points work for every point since the anchors; if
+	// so, points constrain later chords too. if not, the cones are spoiled
+	// until the next reset()
+	bool admit(const SDL_FPoint* points, float tolerance)
+	{
+		float px[4], py[4];
+		int refused[4];
+		for (int e = 0; e < 4; e++)
+			px[e] = points[e].x, py[e] = points[e].y;
+
+		// no branches or short circuits, so this stays one vector (sqrtf needs
+		// -fno-math-errno for that)
+		for (int e = 0; e < 4; e++)
+		{
+			float vx = px[e] - ax[e], vy = py[e] - ay[e];
+			float d = sqrtf(vx * vx + vy * vy);
+			bool near = d <= tolerance, far = d > tolerance; // near the anchor is near any chord from it
+			bool outside = (open[e] <= 0) & ((lox[e] * vy - loy[e] * vx < 0) | (vx * hiy[e] - vy * hix[e] < 0));
+			refused[e] = (near & (reach[e] > tolerance)) | (far & ((d < reach[e]) | outside));
+
+			// the directions within asin(tolerance / d) of the point's
+			float inverse = 1 / std::max(d, tolerance); // unused when near, but no branch
+			float sine = tolerance * inverse, cosine = sqrtf(1 - sine * sine);
+			float ux = vx * inverse, uy = vy * inverse;
+			float lx = ux * cosine + uy * sine, ly = uy * cosine - ux * sine;
+			float hx = ux * cosine - uy * sine, hy = uy * cosine + ux * sine;
+
+			bool low = far & ((open[e] > 0) | (lox[e] * ly - loy[e] * lx > 0));
+			bool high = far & ((open[e] > 0) | (hx * hiy[e] - hy * hix[e] > 0));
+			lox[e] = low ? lx : lox[e];
+			loy[e] = low ? ly : loy[e];
+			hix[e] = high ? hx : hix[e];
+			hiy[e] = high ? hy : hiy[e];
+			open[e] = far ? 0 : open[e];
+			reach[e] = far ? d : reach[e];
+		}
+		return !(refused[0] | refused[1] | refused[2] | refused[3]);
+	}
+};
+
+// write the two vertices of each ribbon at one point, from its four edges (track left, right, core left, right)
+inline void ribbon_point(SDL_Vertex* track, SDL_Vertex* curve, int index, const SDL_FPoint* edges, SDL_Color color, SDL_Color center)
+{
+	track[2 * index] = { edges[0], color, SDL_FPoint{ 0 } };
+	track[2 * index + 1] = { edges[1], color, SDL_FPoint{ 0 } };
+	curve[2 * index] = { edges[2], center, SDL_FPoint{ 0 } };
+	curve[2 * index + 1] = { edges[3], center, SDL_FPoint{ 0 } };
+}
+
+// turns count points (anything with .x and .y) straight into the vertices of
+// two ribbons along them: a wide track of half-width push, coloured per point
+// from palette, and a narrow core of half-width core. points map to pixels as
+// (x0 + k * x, y0 + k * y). each point gives two vertices per ribbon, left
+// then right, shared by the triangles on either side of it; draw them with
+// the index buffer from ribbon_indices(). the work goes through the curve in
+// tiles small enough to stay in L1, each in a few passes over flat float
+// arrays that the compiler vectorizes: project, measure each segment once,
+// average unit directions into normals, then write the vertices. interior
+// normals are averages of unit directions and not normalized again, which
+// rounds off corners.
+//
+// given a tolerance in pixels, points are dropped while every dropped
+// vertex of all four ribbon edges stays within it of the chord that replaces
+// it (see Cones), so straight, slow stretches collapse to a few segments and
+// tight curves keep every point. this runs in the same pass, one point at a
+// time, after the normals are known: testing the edges rather than the
+// centre accounts for the normals turning, which is what a wide track shows
+// first. the test costs several times what it saves on busy material, so
+// once more than three quarters of the points seen (after the first 64) have
+// been kept, the rest of the curve is written without it. even so, a frame
+// takes longer on the CPU than writing every point, and only a renderer short
+// of vertex throughput gains, so decimation is opt-in (tolerance 0, the
+// default, skips it). returns the number of points written; their triangles
+// are the first 6 * (that - 1) indices of the same buffer
+template <Smoothing type, typename Point>
+int ribbon(const Point* points, int count, float x0, float y0, float k, float push, float core, float smoothing,
+		   const SDL_Color* palette, SDL_Color center, SDL_Vertex* track, SDL_Vertex* curve, float tolerance = 0)
+{
+	const int tile = 256;
+	float x[tile + 3], y[tile + 3]; // points first - 1 to last + 1
+	float ux[tile + 2], uy[tile + 2]; // unit directions of the segments between them
+	float nx[tile + 1], ny[tile + 1]; // normals at first to last
+
+	// decimation: the edges of the newest point not yet written, and their cones
+	const int patience = 64; // points seen before giving up on decimation is considered
+	Cones cones;
+	SDL_FPoint held[4] = {};
+	int holding = -1;
+	int kept = 0; // points written
+	int shift = 0; // points dropped before decimation was given up
+
+	for (int first = 0; first < count - 1; first += tile)
+	{
+		int last = std::min(first + tile, count - 1); // normals to find; points first to last - 1 get written
+		int lo = std::max(first - 1, 0);
+		int hi = std::min(last + 1, count - 1);
+		int points_in = hi - lo + 1;
+
+		for (int j = 0; j < points_in; j++)
+		{
+			x[j] = x0 + k * points[lo + j].x;
+			y[j] = y0 + k * points[lo + j].y;
+		}
+
+		for (int j = 0; j < points_in - 1; j++)
+		{
+			float dx = x[j + 1] - x[j];
+			float dy = y[j + 1] - y[j];
+			float scale = 1 / norm<type>(dx, dy, smoothing);
+			ux[j] = dx * scale;
+			uy[j] = dy * scale;
+		}
+
+		// normal i sits between segments i - 1 and i, which are i - lo - 1 and
+		// i - lo here; the ends only have one
+		int from = std::max(first, 1);
+		int to = std::min(last, count - 2);
+		for (int i = from; i <= to; i++)
+		{
+			nx[i - first] = (uy[i - lo - 1] + uy[i - lo]) / 2;
+			ny[i - first] = -(ux[i - lo - 1] + ux[i - lo]) / 2;
+		}
+		if (first == 0)
+			nx[0] = uy[0], ny[0] = -ux[0];
+		if (last == count - 1)
+			nx[last - first] = uy[last - lo - 1], ny[last - first] = -ux[last - lo - 1];
+
+		int end = (last == count - 1) ? last + 1 : last; // the final tile writes the final point too
+		int i = first;
+		int s = first - lo;
+		if (tolerance > 0)
+		{
+			for (; i < end; i++, s++)
+			{
+				if (i >= patience && 4 * kept > 3 * i)
+				{
+					if (holding >= 0)
+						ribbon_point(track, curve, kept++, held, palette[holding], center);
+					shift = i - kept;
+					tolerance = 0;
+					break;
+				}
+
+				int n = i - first;
+				SDL_FPoint edges[4] = {
+					{ x[s] + push * nx[n], y[s] + push * ny[n] },
+					{ x[s] - push * nx[n], y[s] - push * ny[n] },
+					{ x[s] + core * nx[n], y[s] + core * ny[n] },
+					{ x[s] - core * nx[n], y[s] - core * ny[n] }
+				};
+
+				if (kept == 0)
+				{
+					ribbon_point(track, curve, kept++, edges, palette[i], center);
+					cones.reset(edges);
+					continue;
+				}
+
+				// if not, the held point ends the last chord and anchors the next; a
+				// point always fits fresh cones, so there is one
+				if (!cones.admit(edges, tolerance))
+				{
+					ribbon_point(track, curve, kept++, held, palette[holding], center);
+					cones.reset(held);
+					cones.admit(edges, tolerance);
+				}
+
+				holding = i;
+				for (int e = 0; e < 4; e++)
+					held[e] = edges[e];
+			}
+		}
+
+		for (; i < end; i++, s++)
+		{
+			int n = i - first;
+			SDL_Vertex* t = track + 2 * (i - shift);
+			t[0] = { SDL_FPoint{ x[s] + push * nx[n], y[s] + push * ny[n] }, palette[i], SDL_FPoint{ 0 } };
+			t[1] = { SDL_FPoint{ x[s] - push * nx[n], y[s] - push * ny[n] }, palette[i], SDL_FPoint{ 0 } };
+
+			SDL_Vertex* c = curve + 2 * (i - shift);
+			c[0] = { SDL_FPoint{ x[s] + core * nx[n], y[s] + core * ny[n] }, center, SDL_FPoint{ 0 } };
+			c[1] = { SDL_FPoint{ x[s] - core * nx[n], y[s] - core * ny[n] }, center, SDL_FPoint{ 0 } };
+		}
+	}
+
+	if (tolerance <= 0)
+		return count - shift;
+
+	if (holding >= 0) // the last point always ends the last chord
+		ribbon_point(track, curve, kept++, held, palette[holding], center);
+	return kept;
+}
+
+// the triangles of a count-point ribbon from ribbon(): two per segment, 6 *
+// (count - 1) indices in all. they only depend on count, so fill them once
+inline void ribbon_indices(int count, int* indices)
+{
+	for (int i = 0; i < count - 1; i++)
+	{
+		int l0 = 2 * i, r0 = 2 * i + 1, l1 = 2 * i + 2, r1 = 2 * i + 3;
+		int* triangles = indices + 6 * i;
+		triangles[0] = r0;
+		triangles[1] = r1;
+		triangles[2] = l0;
+		triangles[3] = l0;
+		triangles[4] = l1;
+		triangles[5] = r1;
+	}
+}
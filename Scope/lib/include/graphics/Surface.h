@@ -0,0 +1,36 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include "Color.h"
+
+// what Scope draws on: a RenderWindow on screen, or a Canvas in memory. the
+// calls and coordinates are SDL_Renderer's; points are in window units for
+// line() and circle() (scaled by get_scale()), and in pixels otherwise
+class Surface
+{
+public:
+	Surface(double scale) : scale(scale), current_color({ 0, 0, 0, 255 }) {}
+	virtual ~Surface() {}
+
+	virtual void blend(SDL_BlendMode mode) = 0;
+	virtual void clear() = 0;
+	virtual int color(double r, double g, double b, double a = 1, bool clip = true) = 0;
+	virtual int color(Color& color) = 0;
+	virtual void line(float x1, float y1, float x2, float y2) = 0;
+	virtual void curve(SDL_FPoint* points, int count) = 0;
+	virtual void geometry(SDL_Vertex* vertices, int count) = 0;
+	virtual void geometry(SDL_Vertex* vertices, int count, const int* indices, int icount) = 0;
+	virtual void rectangle(SDL_Rect* rect) = 0;
+	virtual void display() = 0;
+
+	// a filled circle in the current colour, as a fan of triangles
+	void circle(float x, float y, float radius);
+
+	double get_scale();
+
+protected:
+	const double scale;
+	SDL_Color current_color;
+
+	// the channels color() sets, 0 to 255 (or past, unclipped)
+	static SDL_Color channels(double r, double g, double b, double a, bool clip);
+};
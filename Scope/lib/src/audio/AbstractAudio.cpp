@@ -1,13 +1,14 @@
 // AbstractAudio.cpp
 #include "AbstractAudio.h"
 #include "argparse.h"
+#include "offline.h"
+#include "synthetic.h"
 
 using namespace soundmath;
 inline int callback(const void*, void*, unsigned long, const PaStreamCallbackTimeInfo*, PaStreamCallbackFlags, void*);
 
-AbstractAudio::AbstractAudio(int bsize, int SR) : bsize(bsize), SR(SR)
-{
-}
+AbstractAudio::AbstractAudio(int bsize, int SR) : timing(SR), bsize(bsize), SR(SR)
+{ }
 
 AbstractAudio::~AbstractAudio()
 {
@@ -102,6 +103,50 @@ void AbstractAudio::args(int argc, char *argv[])
 		.scan<'i', int>()
 		.help("channels per frame of output");
 
+	program.add_argument("-sr", "--rate")
+		.default_value<int>((int)SR)
+		.required()
+		.scan<'i', int>()
+		.help("sample rate; if given, it becomes the global one, but objects built before args() keep the old one");
+
+	program.add_argument("-b", "--bsize")
+		.default_value<int>((int)bsize)
+		.required()
+		.scan<'i', int>()
+		.help("frames per callback");
+
+	program.add_argument("-f", "--file")
+		.default_value<std::string>("")
+		.help("process a WAV file (- for stdin) as fast as possible instead of a device");
+
+	program.add_argument("-n", "--null")
+		.default_value<std::string>("")
+		.help("feed saw, square, triangle, cycle or noise through a null device instead of a real one");
+
+	program.add_argument("-s", "--seconds")
+		.default_value<double>(10)
+		.scan<'g', double>()
+		.help("how long the null device runs");
+
+	program.add_argument("-r", "--free")
+		.help("let the null device run as fast as possible instead of at the device's cadence")
+		.default_value(false)
+		.implicit_value(true);
+
+	program.add_argument("-rt", "--realtime")
+		.default_value<int>(-1)
+		.scan<'i', int>()
+		.help("set up the audio thread for real time: flush denormals, lock memory, and use SCHED_FIFO at this priority if it is over 0");
+
+	program.add_argument("-p", "--pin")
+		.default_value<int>(-1)
+		.scan<'i', int>()
+		.help("pin the audio thread to this cpu (with -rt)");
+
+	program.add_argument("-t", "--timings")
+		.default_value<std::string>("")
+		.help("file to write callback timing statistics to at shutdown");
+
 	program.add_argument("-d", "--devices")
 		.help("list audio device names and exits")
 		.default_value(false)
@@ -123,6 +168,22 @@ void AbstractAudio::args(int argc, char *argv[])
 	in_channel = program.get<int>("-c");
 	out_device = program.get<int>("-o");
 	out_chans = program.get<int>("-of");
+	timings = program.get<std::string>("-t");
+	file = program.get<std::string>("-f");
+	SR = std::min(MAX_SR, std::max(1, program.get<int>("-sr")));
+	if (program.is_used("-sr"))
+		soundmath::SR = SR;
+	timing.sampleRate(SR);
+	bsize = std::max(1, program.get<int>("-b"));
+
+	if (program.get<int>("-rt") >= 0)
+	{
+		setup = Realtime(program.get<int>("-rt"), program.get<int>("-p"));
+		realtime = &setup;
+	}
+	synthetic = program.get<std::string>("-n");
+	seconds = program.get<double>("-s");
+	paced = !program.get<bool>("-r");
 
 	initialize(program.is_used("-d"));
 
@@ -134,6 +195,37 @@ void AbstractAudio::args(int argc, char *argv[])
 
 void AbstractAudio::startup(bool report)
 {
+	if (!file.empty())
+	{
+		// headless: the whole file goes through process() before startup() returns
+		Offline offline([this](const float* in, float* out, unsigned long frames)
+		{
+			return process(in, out, frames);
+		}, bsize, in_chans, out_chans, SR);
+
+		offline.run(file, &timing, report);
+		return;
+	}
+
+	if (!synthetic.empty())
+	{
+		// headless, like a file; blocks for the given seconds when paced
+		Wave<double>* forms[4] = {&saw, &square, &triangle, &cycle};
+		std::string names[4] = {"saw", "square", "triangle", "cycle"};
+		Wave<double>* form = NULL; // noise
+		for (int i = 0; i < 4; i++)
+			if (synthetic == names[i])
+				form = forms[i];
+
+		Synthetic null([this](const float* in, float* out, unsigned long frames)
+		{
+			return process(in, out, frames);
+		}, form, 220, 0.5, 0, bsize, in_chans, out_chans, SR);
+
+		null.run(seconds, paced, &timing, report);
+		return;
+	}
+
 	startup(in_chans, out_chans, report, in_device, out_device);
 }
 
@@ -188,6 +280,9 @@ void AbstractAudio::startup(int in_chans, int out_chans, bool report, int in_dev
 	}
 
 	clean(Pa_OpenStream(&stream, &inParams, &outParams, SR, bsize, 0, callback, this));
+	if (realtime)
+		realtime->prepare(); // memory locking is process-wide; the callback only does the per-thread part
+	timing.watch(stream);
 	clean(Pa_StartStream(stream));
 	running = true;
 }
@@ -205,6 +300,12 @@ void AbstractAudio::shutdown()
 		clean(Pa_CloseStream(stream));
 		clean(Pa_Terminate());
 		running = false;
+
+		if (realtime && entered)
+			realtime->report(std::cout);
+
+		if (!timings.empty() && !timing.dump(timings))
+			std::cout << "couldn't write callback timings to " << timings << std::endl;
 	}
 }
 
@@ -226,6 +327,15 @@ int callback(const void* inputBuffer, void* outputBuffer,
 			  void* userData)
 {
 	AbstractAudio* A = (AbstractAudio*)userData;
+	if (A->realtime && !A->entered)
+	{
+		A->realtime->enter();
+		A->entered = true;
+	}
+
+	A->timing.begin(framesPerBuffer, statusFlags);
+	A->time = timeInfo->inputBufferAdcTime;
 	A->process((const float*) inputBuffer, (float*) outputBuffer, framesPerBuffer);
+	A->timing.end();
 	return 0;
 }
\ No newline at end of file
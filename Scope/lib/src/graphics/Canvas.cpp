@@ -0,0 +1,335 @@
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Canvas.h"
+
+Canvas::Canvas(int width, int height, const bool highDPI, FILE* output) :
+	Surface(highDPI ? 2 : 1), output(output), mode(SDL_BLENDMODE_BLEND)
+{
+	columns = std::max(1, (int)(scale * width));
+	rows = std::max(1, (int)(scale * height));
+	buffer = new Uint32[columns * rows]();
+}
+
+Canvas::~Canvas()
+{
+	delete [] buffer;
+}
+
+void Canvas::blend(SDL_BlendMode mode)
+{
+	switch (mode)
+	{
+		case SDL_BLENDMODE_NONE:
+		case SDL_BLENDMODE_BLEND:
+		case SDL_BLENDMODE_ADD:
+		case SDL_BLENDMODE_MOD:
+		case SDL_BLENDMODE_MUL:
+			this->mode = mode;
+			break;
+		default:
+			this->mode = SDL_BLENDMODE_BLEND;
+	}
+}
+
+static Uint32 pack(SDL_Color color)
+{
+	return (Uint32)color.r | ((Uint32)color.g << 8) | ((Uint32)color.b << 16) | ((Uint32)color.a << 24);
+}
+
+void Canvas::clear()
+{
+	std::fill(buffer, buffer + columns * rows, pack(current_color));
+}
+
+int Canvas::color(double r, double g, double b, double a, bool clip)
+{
+	current_color = channels(r, g, b, a, clip);
+	return 0;
+}
+
+int Canvas::color(Color& color)
+{
+	current_color = color.raw();
+	return 0;
+}
+
+const int lanes = 8; // pixels per block: one AVX2 vector of floats, two NEON ones
+
+// a block of pixels blended the way SDL blends: channels (0 to 255) start at
+// r0, g0, b0, a0 and change by dr, dg, db, da per pixel. one fixed-length loop
+// per mode, with nothing inside it the compiler can't turn into vector code.
+// that rules out float comparisons (they may trap), so results are only
+// clamped once they are integers
+template <SDL_BlendMode mode> static inline void block(Uint32* pixels, float r0, float g0, float b0, float a0, float dr, float dg, float db, float da)
+{
+	for (int i = 0; i < lanes; i++)
+	{
+		float r = r0 + i * dr, g = g0 + i * dg, b = b0 + i * db, a = a0 + i * da;
+
+		int p = (int)pixels[i];
+		float R = p & 0xFF, G = (p >> 8) & 0xFF, B = (p >> 16) & 0xFF, A = (p >> 24) & 0xFF;
+
+		if constexpr (mode == SDL_BLENDMODE_BLEND) // src * srcA + dst * (1 - srcA); alpha src + dst * (1 - srcA)
+		{
+			float k = a * (1.0f / 255), l = 1 - k;
+			R = r * k + R * l;
+			G = g * k + G * l;
+			B = b * k + B * l;
+			A = a + A * l;
+		}
+		else if constexpr (mode == SDL_BLENDMODE_ADD) // src * srcA + dst; alpha dst
+		{
+			float k = a * (1.0f / 255);
+			R = r * k + R;
+			G = g * k + G;
+			B = b * k + B;
+		}
+		else if constexpr (mode == SDL_BLENDMODE_MOD) // src * dst; alpha dst
+		{
+			R = r * R * (1.0f / 255);
+			G = g * G * (1.0f / 255);
+			B = b * B * (1.0f / 255);
+		}
+		else if constexpr (mode == SDL_BLENDMODE_MUL) // src * dst + dst * (1 - srcA); alpha dst
+		{
+			float l = 1 - a * (1.0f / 255);
+			R = r * R * (1.0f / 255) + R * l;
+			G = g * G * (1.0f / 255) + G * l;
+			B = b * B * (1.0f / 255) + B * l;
+		}
+		else
+		{
+			R = r;
+			G = g;
+			B = b;
+			A = a;
+		}
+
+		int r8 = std::min(255, std::max(0, (int)(R + 0.5f)));
+		int g8 = std::min(255, std::max(0, (int)(G + 0.5f)));
+		int b8 = std::min(255, std::max(0, (int)(B + 0.5f)));
+		int a8 = std::min(255, std::max(0, (int)(A + 0.5f)));
+		pixels[i] = (Uint32)(r8 | (g8 << 8) | (b8 << 16) | (a8 << 24));
+	}
+}
+
+// a run of pixels, channels starting at start[] and changing by step[] per
+// pixel: whole blocks in place, then the ragged end through a scratch block,
+// so no pixel goes through a scalar loop. spans along thin triangles are
+// short, and a scalar tail would cost more than the rest of the span
+template <SDL_BlendMode mode> static void fill(Uint32* pixels, int count, const float* start, const float* step)
+{
+	int whole = count - count % lanes;
+	for (int i = 0; i < whole; i += lanes)
+		block<mode>(pixels + i, start[0] + i * step[0], start[1] + i * step[1], start[2] + i * step[2], start[3] + i * step[3],
+					step[0], step[1], step[2], step[3]);
+
+	if (whole < count)
+	{
+		Uint32 tail[lanes] = { 0 };
+		memcpy(tail, pixels + whole, (count - whole) * sizeof(Uint32));
+		block<mode>(tail, start[0] + whole * step[0], start[1] + whole * step[1], start[2] + whole * step[2], start[3] + whole * step[3],
+					step[0], step[1], step[2], step[3]);
+		memcpy(pixels + whole, tail, (count - whole) * sizeof(Uint32));
+	}
+}
+
+void Canvas::span(Uint32* pixels, int count, const float* start, const float* step)
+{
+	switch (mode)
+	{
+		case SDL_BLENDMODE_NONE:
+			fill<SDL_BLENDMODE_NONE>(pixels, count, start, step);
+			break;
+		case SDL_BLENDMODE_ADD:
+			fill<SDL_BLENDMODE_ADD>(pixels, count, start, step);
+			break;
+		case SDL_BLENDMODE_MOD:
+			fill<SDL_BLENDMODE_MOD>(pixels, count, start, step);
+			break;
+		case SDL_BLENDMODE_MUL:
+			fill<SDL_BLENDMODE_MUL>(pixels, count, start, step);
+			break;
+		default:
+			fill<SDL_BLENDMODE_BLEND>(pixels, count, start, step);
+	}
+}
+
+// the first pixel index whose centre is at or past v, kept within [0, limit]
+static int boundary(float v, int limit)
+{
+	return (int)std::max(0.0f, std::min((float)limit, ceilf(v - 0.5f)));
+}
+
+// fills the pixels whose centres are inside, or on a top or left edge, in
+// rows from to to - 1: each row is one span between the long edge (top to
+// bottom vertex) and whichever short edge it crosses. every channel is a
+// plane over the triangle, so along a span it only needs a start and a step
+void Canvas::triangle(const SDL_Vertex& a, const SDL_Vertex& b, const SDL_Vertex& c, int from, int to)
+{
+	const SDL_FPoint& p0 = a.position;
+	const SDL_FPoint& p1 = b.position;
+	const SDL_FPoint& p2 = c.position;
+	float area = (p1.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p1.y - p0.y);
+	if (!(area != 0)) // degenerate, or not a number
+		return;
+
+	float base[4], ddx[4], ddy[4]; // channel at (x, y) = base + x * ddx + y * ddy
+	for (int i = 0; i < 4; i++)
+	{
+		float c0 = (&a.color.r)[i], c1 = (&b.color.r)[i], c2 = (&c.color.r)[i];
+		ddx[i] = ((c1 - c0) * (p2.y - p0.y) - (c2 - c0) * (p1.y - p0.y)) / area;
+		ddy[i] = ((c2 - c0) * (p1.x - p0.x) - (c1 - c0) * (p2.x - p0.x)) / area;
+		base[i] = c0 - p0.x * ddx[i] - p0.y * ddy[i];
+	}
+
+	const SDL_FPoint* v[3] = { &p0, &p1, &p2 }; // top to bottom
+	if (v[1]->y < v[0]->y)
+		std::swap(v[0], v[1]);
+	if (v[2]->y < v[1]->y)
+		std::swap(v[1], v[2]);
+	if (v[1]->y < v[0]->y)
+		std::swap(v[0], v[1]);
+
+	// x per unit y along each edge; an edge no row crosses is never used
+	float along = (v[2]->x - v[0]->x) / std::max(v[2]->y - v[0]->y, 1e-30f);
+	float upper = (v[1]->x - v[0]->x) / std::max(v[1]->y - v[0]->y, 1e-30f);
+	float lower = (v[2]->x - v[1]->x) / std::max(v[2]->y - v[1]->y, 1e-30f);
+
+	int top = std::max(from, boundary(v[0]->y, rows)), bottom = std::min(to, boundary(v[2]->y, rows));
+	for (int y = top; y < bottom; y++)
+	{
+		float cy = y + 0.5f;
+		float x1 = v[0]->x + (cy - v[0]->y) * along;
+		float x2 = (cy < v[1]->y) ? v[0]->x + (cy - v[0]->y) * upper : v[1]->x + (cy - v[1]->y) * lower;
+
+		int left = boundary(std::min(x1, x2), columns), right = boundary(std::max(x1, x2), columns);
+		if (left >= right)
+			continue;
+
+		float start[4], cx = left + 0.5f;
+		for (int i = 0; i < 4; i++)
+			start[i] = base[i] + cx * ddx[i] + cy * ddy[i];
+		span(buffer + y * columns + left, right - left, start, ddx);
+	}
+}
+
+void Canvas::dot(int x, int y)
+{
+	if (x < 0 || x >= columns || y < 0 || y >= rows)
+		return;
+
+	const float still[4] = { 0 };
+	float start[4] = { (float)current_color.r, (float)current_color.g, (float)current_color.b, (float)current_color.a };
+	span(buffer + y * columns + x, 1, start, still);
+}
+
+// one pixel per step along the longer axis; a polyline skips the first pixel
+// of each segment after its first, so joints aren't blended twice
+void Canvas::segment(float x1, float y1, float x2, float y2, bool skip)
+{
+	float dx = x2 - x1, dy = y2 - y1;
+	float length = std::max(fabsf(dx), fabsf(dy));
+	if (!(length < 4 * (columns + rows))) // far too long to be on screen, or not a number
+		return;
+
+	int steps = (int)ceilf(length);
+	for (int i = skip ? 1 : 0; i <= steps; i++)
+	{
+		float t = steps ? (float)i / steps : 0;
+		dot((int)floorf(x1 + t * dx), (int)floorf(y1 + t * dy));
+	}
+}
+
+void Canvas::line(float x1, float y1, float x2, float y2)
+{
+	segment(scale * x1, scale * y1, scale * x2, scale * y2, false);
+}
+
+void Canvas::curve(SDL_FPoint* points, int count)
+{
+	for (int i = 0; i + 1 < count; i++)
+		segment(points[i].x, points[i].y, points[i + 1].x, points[i + 1].y, i > 0);
+}
+
+// the triangles in order, one horizontal strip of the canvas at a time, so
+// each strip stays in cache while everything over it is drawn; a tall, thin
+// triangle would otherwise walk the whole frame a cache line per row, and a
+// ribbon overdraws every pixel many times. a pixel is in one strip only, so
+// this draws exactly what drawing the triangles one by one would
+void Canvas::batch(const SDL_Vertex* vertices, int count, const int* indices, int icount)
+{
+	int strip = std::max(8, (1 << 18) / (int)sizeof(Uint32) / columns); // rows per 256 kB
+	for (int from = 0; from < rows; from += strip)
+	{
+		int to = std::min(rows, from + strip);
+		for (int i = 0; i + 2 < icount; i += 3)
+		{
+			int a = indices ? indices[i] : i, b = indices ? indices[i + 1] : i + 1, c = indices ? indices[i + 2] : i + 2;
+			if (a < 0 || a >= count || b < 0 || b >= count || c < 0 || c >= count)
+				continue;
+
+			float ya = vertices[a].position.y, yb = vertices[b].position.y, yc = vertices[c].position.y;
+			if (std::max(ya, std::max(yb, yc)) < from || std::min(ya, std::min(yb, yc)) > to)
+				continue;
+			triangle(vertices[a], vertices[b], vertices[c], from, to);
+		}
+	}
+}
+
+void Canvas::geometry(SDL_Vertex* vertices, int count)
+{
+	batch(vertices, count, NULL, count);
+}
+
+// indexed: each three of the icount indices pick the vertices of a triangle
+void Canvas::geometry(SDL_Vertex* vertices, int count, const int* indices, int icount)
+{
+	batch(vertices, count, indices, icount);
+}
+
+// NULL fills the whole canvas, like SDL_RenderFillRect
+void Canvas::rectangle(SDL_Rect* rect)
+{
+	int left = 0, top = 0, right = columns, bottom = rows;
+	if (rect)
+	{
+		left = std::max(0, rect->x);
+		top = std::max(0, rect->y);
+		right = std::min(columns, rect->x + rect->w);
+		bottom = std::min(rows, rect->y + rect->h);
+	}
+
+	const float still[4] = { 0 };
+	float start[4] = { (float)current_color.r, (float)current_color.g, (float)current_color.b, (float)current_color.a };
+	for (int y = top; y < bottom && left < right; y++)
+		span(buffer + y * columns + left, right - left, start, still);
+}
+
+void Canvas::display()
+{
+	if (output)
+	{
+		fwrite(buffer, sizeof(Uint32), columns * rows, output);
+		fflush(output);
+	}
+}
+
+const Uint32* Canvas::pixels()
+{
+	return buffer;
+}
+
+int Canvas::width()
+{
+	return columns;
+}
+
+int Canvas::height()
+{
+	return rows;
+}
@@ -8,7 +8,7 @@
 #include "RenderWindow.h"
 
 RenderWindow::RenderWindow(const char* title, int width, int height, const bool highDPI, Uint32 flags) : 
-	window(NULL), renderer(NULL), scale(highDPI ? 2 : 1)
+	Surface(highDPI ? 2 : 1), window(NULL), renderer(NULL)
 {
 	window = SDL_CreateWindow(title, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width, height, flags | SDL_WINDOW_OPENGL | (highDPI ? SDL_WINDOW_ALLOW_HIGHDPI : 0));
 
@@ -71,30 +71,14 @@ void RenderWindow::render(SDL_Texture* tex)
 
 int RenderWindow::color(double r, double g, double b, double a, bool clip)
 {
-	if (clip)
-	{
-		const static double before = std::nextafter(1.0, 0.0);
-		r = (int)(256 * std::fmax(0, std::fmin(r, before)));
-		g = (int)(256 * std::fmax(0, std::fmin(g, before)));
-		b = (int)(256 * std::fmax(0, std::fmin(b, before)));
-		a = (int)(256 * std::fmax(0, std::fmin(a, before)));
-	}
-	else
-	{
-		r = (int)(256 * r);
-		g = (int)(256 * g);
-		b = (int)(256 * b);
-		a = (int)(256 * a);
-	}
-
-	return SDL_SetRenderDrawColor(renderer, r, g, b, a);
+	current_color = channels(r, g, b, a, clip);
+	return SDL_SetRenderDrawColor(renderer, current_color.r, current_color.g, current_color.b, current_color.a);
 }
 
 int RenderWindow::color(Color& color)
 {
-	current_color = color;
-	SDL_Color raw = color.raw();
-	return SDL_SetRenderDrawColor(renderer, raw.r, raw.g, raw.b, raw.a);
+	current_color = color.raw();
+	return SDL_SetRenderDrawColor(renderer, current_color.r, current_color.g, current_color.b, current_color.a);
 }
 
 void RenderWindow::line(float x1, float y1, float x2, float y2)
@@ -112,32 +96,15 @@ void RenderWindow::geometry(SDL_Vertex* vertices, int count)
 	SDL_RenderGeometry(renderer, NULL, vertices, count, NULL, 0);
 }
 
-void RenderWindow::rectangle(SDL_Rect* rect)
+// indexed: each three of the icount indices pick the vertices of a triangle
+void RenderWindow::geometry(SDL_Vertex* vertices, int count, const int* indices, int icount)
 {
-	SDL_RenderFillRect(renderer, rect);
+	SDL_RenderGeometry(renderer, NULL, vertices, count, indices, icount);
 }
 
-void RenderWindow::circle(float x, float y, float radius)
+void RenderWindow::rectangle(SDL_Rect* rect)
 {
-	int resolution = 12 + (2 * M_PI * radius / 12); // segments per circle
-	float x_coords[resolution];
-	float y_coords[resolution];
-
-	for (int i = 0; i < resolution; i++)
-	{
-		x_coords[i] = scale * (x + radius * cos(2 * M_PI * (double)i / resolution));
-		y_coords[i] = scale * (y + radius * sin(2 * M_PI * (double)i / resolution));
-	}
-
-	SDL_Vertex points[resolution * 3];
-	for (int j = 0; j < resolution; j++)
-	{
-		points[3 * j] = { SDL_FPoint{ x_coords[j], y_coords[j] }, current_color.raw(), SDL_FPoint{ 0 } };
-		points[3 * j + 1] = { SDL_FPoint{ x_coords[(j + 1) % resolution], y_coords[(j + 1) % resolution] }, current_color.raw(), SDL_FPoint{ 0 } };
-		points[3 * j + 2] = { SDL_FPoint{ float(scale * x), float(scale * y) }, current_color.raw(), SDL_FPoint{ 0 } };
-	}
-
-	geometry(points, resolution * 3);
+	SDL_RenderFillRect(renderer, rect);
 }
 
 void RenderWindow::display()
@@ -153,9 +120,4 @@ SDL_Window* RenderWindow::sdl_window()
 SDL_GLContext RenderWindow::gl_context()
 {
 	return context;
-}
-
-double RenderWindow::get_scale()
-{
-	return scale;
 }
\ No newline at end of file
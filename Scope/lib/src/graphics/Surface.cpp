@@ -0,0 +1,54 @@
+#include <SDL2/SDL.h>
+
+#include <cmath>
+#include <vector>
+
+#include "Surface.h"
+
+SDL_Color Surface::channels(double r, double g, double b, double a, bool clip)
+{
+	if (clip)
+	{
+		const static double before = std::nextafter(1.0, 0.0);
+		r = (int)(256 * std::fmax(0, std::fmin(r, before)));
+		g = (int)(256 * std::fmax(0, std::fmin(g, before)));
+		b = (int)(256 * std::fmax(0, std::fmin(b, before)));
+		a = (int)(256 * std::fmax(0, std::fmin(a, before)));
+	}
+	else
+	{
+		r = (int)(256 * r);
+		g = (int)(256 * g);
+		b = (int)(256 * b);
+		a = (int)(256 * a);
+	}
+
+	return { (Uint8)(int)r, (Uint8)(int)g, (Uint8)(int)b, (Uint8)(int)a };
+}
+
+void Surface::circle(float x, float y, float radius)
+{
+	int resolution = 12 + (2 * M_PI * radius / 12); // segments per circle
+	std::vector<SDL_FPoint> rim(resolution);
+	for (int i = 0; i < resolution; i++)
+	{
+		rim[i].x = scale * (x + radius * cos(2 * M_PI * (double)i / resolution));
+		rim[i].y = scale * (y + radius * sin(2 * M_PI * (double)i / resolution));
+	}
+
+	SDL_FPoint centre = { float(scale * x), float(scale * y) };
+	std::vector<SDL_Vertex> points(resolution * 3);
+	for (int j = 0; j < resolution; j++)
+	{
+		points[3 * j] = { rim[j], current_color, SDL_FPoint{ 0, 0 } };
+		points[3 * j + 1] = { rim[(j + 1) % resolution], current_color, SDL_FPoint{ 0, 0 } };
+		points[3 * j + 2] = { centre, current_color, SDL_FPoint{ 0, 0 } };
+	}
+
+	geometry(points.data(), resolution * 3);
+}
+
+double Surface::get_scale()
+{
+	return scale;
+}
@@ -1,8 +1,11 @@
 #include <SDL2/SDL.h>
 #include <iostream>
 #include <unistd.h>
+#include <climits>
 
 #include "RenderWindow.h"
+#include "Canvas.h"
+#include "Ribbon.h"
 #include "argparse.h"
 
 #include "audio.h"
@@ -10,6 +13,12 @@
 #include "synth.h"
 #include "filter.h"
 #include "metro.h"
+#include "ring.h"
+#include "analysis.h"
+#include "params.h"
+#include "pool.h"
+#include "recorder.h"
+#include "subspace.h"
 
 int screen_width;
 int screen_height;
@@ -17,15 +26,17 @@ const int width = 1920; // 800;
 const int height = 1080; // 800;
 const bool highDPI = true;
 const double correction = (highDPI ? 1 : 0.5);
+double density = 1; // pixels per screen unit on what is drawn to
 bool fullscreen = false;
 bool mouse = true;
+std::string headless; // file to write raw RGBA frames to, drawn on the CPU, instead of opening a window
+long frames = 0; // frames to draw headless; 0 draws until the input runs out
 
 #define DARKNESS 255
 #define ALPHA 64
 #define LINEALPHA 96
 #define LIGHTNESS 0
 
-#define BSIZE 64
 #define FRAMERATE 60
 #define INCREMENT 1
 
@@ -35,16 +46,32 @@ bool mouse = true;
 
 using namespace soundmath;
 
-const int bsize = 64;
+int bsize = 64;
 int in_chans;
 int out_chans;
 int in_channel;
+bool every = false; // watch every input channel, tiled
+int tracked = 0; // delays in each view's subspace tracker; 0 draws the plain delay pair
+Policy overload = Policy::drop; // what the analysis thread does when it falls behind
+double tolerance = 0; // pixels a decimated ribbon edge may stray; 0 keeps every point. opt-in, as the test costs the CPU more than drawing the points it drops
 int in_device;
 int out_device;
+std::string timings;
+std::string file; // WAV file (- for stdin) to watch instead of the input device, as fast as it reads
+std::string synthetic; // or a waveform (saw, square, triangle, cycle or noise) from a null device
+double seconds = 10; // how long the null device runs
+bool paced = true; // whether the null device keeps a real device's cadence
+std::atomic<bool> finished{false}; // the file or null device has run out
+std::atomic<bool> quitting{false}; // process() stops the file or null device at its next block
+Realtime setup; // applied to the audio thread with -rt
+std::string recording;
+Recorder::Format depth = Recorder::float32;
+Recorder* recorder = NULL; // every input channel, as it arrives
 
 using namespace soundmath;
 
 void args(int argc, char *argv[]);
+void allocate();
 inline int process(const float* in, float* out);
 Audio A = Audio(process, bsize);
 
@@ -56,206 +83,451 @@ SDL_BlendMode polyblend = SDL_ComposeCustomBlendMode(
 	SDL_BLENDFACTOR_SRC_ALPHA, // SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
 	SDL_BLENDOPERATION_MINIMUM);
 
-const int waveSize = SR / FRAMERATE;
+int waveSize; // samples per video frame; set, with everything sized by it, in allocate()
 
-SDL_FPoint waveform[2 * waveSize];
-SDL_FPoint Loffsets[2 * waveSize];
-SDL_FPoint Roffsets[2 * waveSize];
+// a raw input sample, stamped with its stream time in seconds
+struct Sample
+{
+	float value;
+	double time;
+};
+
+// a sample and its delayed copy
+struct Frame
+{
+	float x, y;
+};
 
-SDL_FPoint Lcurves[2 * waveSize];
-SDL_FPoint Rcurves[2 * waveSize];
+// one input channel: its trace and geometry. the analysis thread distorts
+// and delays every view's samples into its own ring; the render loop moves
+// them into the trace and draws. workers handle the views in parallel
+struct View
+{
+	int channel;
+
+	// analysis thread -> render loop; a few frames' worth of slack
+	Ring<Frame>* frames;
+	Frame* outgoing;
+	Frame* incoming;
+	std::atomic<double> latest{0}; // stream time of the newest sample analyzed
+
+	Frame* trace; // the latest frames, newest first; allows for circular buffering without modulo
+	int traceOrigin = 0;
+
+	// the distortion's state; analysis thread only
+	Delay<double>* delay;
+	Synth<double>* carrier;
+	double amplitude = 0;
+
+	// with --subspace, the plane a tracker follows through the embedding of
+	// the distorted samples replaces the (sample, delayed sample) pair
+	Subspace<float>* tracker = NULL;
+	float* samples;
+	float* coordinates;
+
+	SDL_Vertex* trackverts; // two per point; see ribbon()
+	SDL_Vertex* curveverts;
+	int kept; // points left after decimation
+};
 
+View* views;
+int viewCount = 1;
+Pool* pool; // the render loop's
+Pool* analysts; // the analysis thread's
 
-SDL_FPoint normals[2 * waveSize];
+// callback -> analysis thread: frames of viewCount stamped samples
+Analysis<Sample>* analysis;
+Sample* stamped;
+void analyze(const Sample* in, int frames, int stride, int level);
 
-SDL_Vertex trackverts[2 * waveSize * 6];
-SDL_Vertex curveverts[2 * waveSize * 6];
+double lag = 0; // summed age of the oldest view's newest sample at each display
+long displayed = 0;
 
-SDL_Vertex oldtrack[waveSize * 6];
-SDL_Vertex oldcurve[waveSize * 6];
+// with --headless, what is drawn on instead of a window: by the thread that
+// runs the file or null device, a frame whenever a frame's worth of input is in
+Canvas* canvas = NULL;
+void show(Surface& surface, int most);
 
 SDL_Rect fillRect = { 0, 0, (int)(width * 2 * correction), (int)(height * 2 * correction) };
 
 const int pushoff = 192;
+const double smooth = 256; // 64; smoothing term of the norm when finding normals
+
+SDL_Color* palette; // track colour of each point
+int* triangles; // indices into a view's vertices; the same every frame
+const SDL_Color white = { 255, 255, 255, 128 }; // the core
 
 double phase = 0;
 double mod = 0;
 double modfreq = 1.5 * 0.75; // 0.75;
 double freq = 1.5 * 0.05; // rate at which oscillator completes revolution
 
-int waveOrigin = 0;
-double gain = 5;
-int dtime = SR / 20;
-
-Delay<double> chandelay(1, SR);
+// keyboard -> analysis; picked up once per block, smoothed per sample
+enum Control
+{
+	delaytime,
+	distortion,
+	controls
+};
+Parameters params(controls);
 
-bool ready = false;
-bool flipped = false;
+// the render loop both sets and reads the zoom, so it is smoothed there, per frame
+double zoom = 5;
+double zoomed = zoom;
 
-double squared = 0;
-double amplitude = 0;
 double up = 0.1; // attack parameter
 double down = 0.0001; // decay parameter
-double mix = 0; // lives in [0,1]; controls mix of distorted / dry. 0 is dry.
-double pan; // funtion of mix
-bool distorted = false;
-double responsiveness = 0.0001;
-
-Synth<double> carrier(&cycle, 0);
 
-inline int process(const float* in, float* out)
+// everything that depends on the sample rate or frame size, once they are known
+void allocate()
 {
-	for (int i = 0; i < BSIZE; i++)
+	waveSize = SR / FRAMERATE;
+
+	viewCount = every ? in_chans : 1;
+	views = new View[viewCount];
+	for (int v = 0; v < viewCount; v++)
 	{
-		double the_input = in[in_chans * i + in_channel];
+		View& view = views[v];
+		view.channel = every ? v : in_channel;
 
-		squared = the_input * the_input;
-		if (squared > amplitude)
-			amplitude = up * squared + (1 - up) * amplitude;
-		else
-			amplitude = down * squared + (1 - down) * amplitude;
+		view.frames = new Ring<Frame>(4 * std::max(waveSize, bsize));
+		view.outgoing = new Frame[bsize];
+		view.incoming = new Frame[waveSize];
+		view.trace = new Frame[2 * waveSize]();
 
-		carrier.phasemod(sin(30 * (1 + amplitude) * the_input) / 2);
+		view.delay = new Delay<double>(1, SR);
+		view.carrier = new Synth<double>(&cycle, 0);
 
-		mix = (1 - responsiveness) * mix + responsiveness * int(distorted);
-		pan = (1 + cos(PI * mix * 0.8)) / 2;
-		double the_sample = pan * the_input + (1 - pan) * sin(amplitude * carrier()/ 10 + 20 * (1 + amplitude) * the_input) / 10;
+		view.trackverts = new SDL_Vertex[waveSize * 2];
+		view.curveverts = new SDL_Vertex[waveSize * 2];
+
+		// a ladder over the default delay time; the delay keys don't move it
+		if (tracked > 1)
+		{
+			std::vector<uint> ladder(tracked);
+			for (int i = 0; i < tracked; i++)
+				ladder[i] = (uint)((double)i * (SR / 20) / (tracked - 1));
+			view.tracker = new Subspace<float>(ladder, 2, 0.999, 0.05, Tracking::past, true, true);
+			view.samples = new float[bsize];
+			view.coordinates = new float[2 * bsize];
+		}
+	}
+	pool = new Pool(std::min<int>(viewCount, std::max(1u, std::thread::hardware_concurrency())));
+	analysts = new Pool(std::min<int>(viewCount, std::max(1u, std::thread::hardware_concurrency())));
 
-		carrier.tick();
+	stamped = new Sample[bsize * viewCount];
+	analysis = new Analysis<Sample>(analyze, bsize, overload, 0.05, 1, SR, viewCount);
 
-		out[i] = 0; // the_sample;
+	// the colour drift is switched off (see the 0 * mod), so the palette only
+	// depends on the position along the trace and is worked out once
+	palette = new SDL_Color[waveSize];
+	for (int i = 0; i < waveSize; i++)
+	{
+		unsigned char R = (unsigned char)(255 * (1 + sin(2 * PI * (0.0 / 3 * cos(/* toggle color change */ 0 * mod * freq / modfreq) / 2 + 1 * (double)i / waveSize ))) / 2);
+		unsigned char G = (unsigned char)(255 * (1 + sin(2 * PI * (1.0 / 3 * cos(/* toggle color change */ 0 * mod * freq / modfreq) / 2 + 1 * (double)i / waveSize ))) / 2);
+		unsigned char B = (unsigned char)(255 * (1 + sin(2 * PI * (2.0 / 3 * cos(/* toggle color change */ 0 * mod * freq / modfreq) / 2 + 1 * (double)i / waveSize ))) / 2);
+		palette[i] = SDL_Color { R, G, B, (unsigned char)(10) };
+	}
 
-		double scale = std::min(screen_width, screen_height);
-		waveform[waveOrigin + waveSize * flipped] = 
-			SDL_FPoint{
-				float((1 + highDPI) * (screen_width + gain * the_sample * scale) / 2),
-				float((1 + highDPI) * (screen_height + gain * chandelay(the_sample) * scale) / 2)
-			};
+	triangles = new int[(waveSize - 1) * 6];
+	ribbon_indices(waveSize, triangles);
 
-		waveOrigin--;
-		if (waveOrigin < 0)
+	// the rings, traces and the analysis queue are cleared as they are built;
+	// fault in the rest now rather than on the first frames (see Realtime)
+	if (A.realtime)
+	{
+		Realtime::prefault(stamped, bsize * viewCount * sizeof(Sample));
+		for (int v = 0; v < viewCount; v++)
 		{
-			ready = true;
-			flipped = !flipped;
-			waveOrigin += waveSize;
+			Realtime::prefault(views[v].outgoing, bsize * sizeof(Frame));
+			Realtime::prefault(views[v].incoming, waveSize * sizeof(Frame));
+			Realtime::prefault(views[v].trackverts, waveSize * 2 * sizeof(SDL_Vertex));
+			Realtime::prefault(views[v].curveverts, waveSize * 2 * sizeof(SDL_Vertex));
+			if (views[v].tracker)
+			{
+				Realtime::prefault(views[v].samples, bsize * sizeof(float));
+				Realtime::prefault(views[v].coordinates, 2 * bsize * sizeof(float));
+			}
 		}
+	}
+
+	params.smoothing(distortion, Parameters::coefficient(0.1));
+	params.set(delaytime, SR / 20, false);
+	params.set(distortion, 0);
+	params.update();
+	params.settle();
+}
 
-		chandelay.tick();
+// the callback only stamps, picks out the watched channels and copies; everything else happens in analyze()
+inline int process(const float* in, float* out)
+{
+	if (recorder)
+		recorder->push(in, bsize);
+
+	for (int i = 0; i < bsize; i++)
+		for (int v = 0; v < viewCount; v++)
+			stamped[viewCount * i + v] = { in[in_chans * i + views[v].channel], A.time + (double)i / SR };
+
+	if (canvas)
+	{
+		// headless: nothing to keep up with, so no analysis thread and no dropping
+		analyze(stamped, bsize, viewCount, 0);
+		while (views[0].frames->available() >= waveSize && !quitting)
+		{
+			show(*canvas, waveSize);
+			displayed++;
+			if (frames > 0 && displayed >= frames)
+				quitting = true;
+		}
 	}
+	else
+		analysis->push(stamped, bsize, viewCount); // a full queue drops the block, counted as an overrun
 
-	chandelay.coefficients({{dtime,1}},{});
+	memset(out, 0, bsize * out_chans * sizeof(float));
 
-	return 0;
+	return quitting.load(std::memory_order_relaxed); // a device ignores it
 }
 
-enum Smoothing 
+// distort and delay count of a view's samples, stride apart, onto its ring,
+// in order. the distortion mix (in [0,1], 0 is dry) ramps from one value to
+// another over the block
+void distort(View& view, const Sample* in, int count, int stride, double from, double to)
 {
-	constant,
-	L2,
-	L1,
-	L4,
-	LHalf,
-	LInf
-};
+	double& amplitude = view.amplitude;
+	Synth<double>* carrier = view.carrier;
+	Frame* out = view.outgoing;
 
-const double smooth = 256; // 64;
+	for (int i = 0; i < count; i++)
+	{
+		double the_input = in[stride * i].value;
 
-double norm(double x, double y, Smoothing normtype = L2, double smoothing = smooth / waveSize)
-{
-	switch (normtype)
+		double squared = the_input * the_input;
+		if (squared > amplitude)
+			amplitude = up * squared + (1 - up) * amplitude;
+		else
+			amplitude = down * squared + (1 - down) * amplitude;
+
+		carrier->phasemod(sin(30 * (1 + amplitude) * the_input) / 2);
+
+		double mix = from + (to - from) * (i + 1) / count;
+		double pan = (1 + cos(PI * mix * 0.8)) / 2;
+		double the_sample = pan * the_input + (1 - pan) * sin(amplitude * (*carrier)() / 10 + 20 * (1 + amplitude) * the_input) / 10;
+
+		carrier->tick();
+
+		out[i] = { (float)the_sample, (float)(*view.delay)(the_sample) };
+		view.delay->tick();
+		if (view.tracker)
+			view.samples[i] = the_sample;
+	}
+
+	// the tracker's coordinates grow with the root of the embedding's dimension
+	if (view.tracker)
 	{
-		case constant: return 1;
-		case L2: return sqrt(smoothing * smoothing + x * x + y * y);
-		case L1: return abs(smoothing) + abs(x) + abs(y);
-		case L4: return pow(smoothing * smoothing * smoothing * smoothing + x * x * x * x + y * y * y * y, 0.25);
-		case LHalf: return pow(sqrt(abs(smoothing)) + sqrt(abs(x)) + sqrt(abs(y)), 2);
-		case LInf: return std::max(abs(smoothing), std::max(abs(x), abs(y)));
+		view.tracker->process(view.samples, count, 1, view.coordinates);
+		float scale = 1 / sqrtf(tracked);
+		for (int i = 0; i < count; i++)
+			out[i] = { scale * view.coordinates[2 * i], scale * view.coordinates[2 * i + 1] };
 	}
+
+	view.frames->write(out, count); // a full ring drops the rest, counted as an overrun
+	if (count > 0)
+		view.latest.store(in[stride * (count - 1)].time, std::memory_order_relaxed);
 }
 
+// the analysis thread's stage: a block of frames, one stamped sample per
+// view, stride samples apart. a decimated block (stride > viewCount) spans
+// more time per sample, so the delay, counted in samples, shrinks to match
+void analyze(const Sample* in, int frames, int stride, int)
+{
+	int factor = stride / viewCount;
+
+	params.update();
+	double from = params[distortion];
+	params.advance(frames * factor);
+	double to = params[distortion];
+	uint delay = std::max(1u, (uint)params.target(delaytime) / factor);
+
+	analysts->run([in, frames, stride, from, to, delay](int v) {
+		views[v].delay->modulate_forward(0, {delay, 1});
+		distort(views[v], in + v, frames, stride, from, to);
+	}, viewCount);
+}
 
-// fill an array of (hopefully unit) normals
-void gauss(SDL_FPoint* in, SDL_FPoint* normals, int count)
+// render loop (headless, the thread running the input): move up to most of
+// what the analysis has finished into a view's trace
+void take(View& view, int most)
 {
-	const Smoothing normtype = L2;
-	double dx, dy, scale; 
+	Frame* trace = view.trace;
+	int& traceOrigin = view.traceOrigin;
 
-	dx = (double)in[1].x - (double)in[0].x;
-	dy = (double)in[1].y - (double)in[0].y;
+	for (int n = std::min(most, view.frames->available()); n > 0; )
+	{
+		int count = view.frames->read(view.incoming, std::min(n, waveSize));
+		for (int i = 0; i < count; i++)
+		{
+			trace[traceOrigin] = view.incoming[i];
+			trace[traceOrigin + waveSize] = trace[traceOrigin];
 
-	scale = norm(dx, dy, normtype); // sqrt(dx * dx + dy * dy);
-	assert(scale != 0);
+			traceOrigin--;
+			if (traceOrigin < 0)
+				traceOrigin += waveSize;
+		}
+		n -= count;
+	}
+}
 
-	normals[0] = { (float)(dy / scale), (float)(-dx / scale) };
+// project a view's trace into the tile at (left, top), w x h screen units,
+// and build its vertices
+void draw(View& view, double left, double top, double w, double h)
+{
+	double scale = std::min(w, h);
+	double spread = scale / std::min(screen_width, screen_height); // widths shrink with the tile
+	double gain = zoomed;
+
+	// the newest waveSize frames, newest first, mapped into the tile
+	view.kept = ribbon<L2>(view.trace + view.traceOrigin + 1, waveSize,
+		density * (left + w / 2), density * (top + h / 2), density * gain * scale / 2,
+		pushoff * spread, 5 * spread, smooth / waveSize, palette, white, view.trackverts, view.curveverts, tolerance);
+}
 
-	dx = in[count - 1].x - in[count - 2].x;
-	dy = in[count - 1].y - in[count - 2].y;
+// draw a frame of every view, after moving up to most new frames into each trace
+void show(Surface& surface, int most)
+{
+	for (int v = 0; v < viewCount; v++)
+		take(views[v], most);
 
-	scale = norm(dx, dy, normtype); 
-	assert(scale != 0);
+	zoomed += Parameters::coefficient(0.05, FRAMERATE) * (zoom - zoomed);
 
-	normals[count - 1] = { (float)(dy / scale), (float)(-dx / scale) };
+	// each view gets a tile of a grid as close to square as the count allows
+	int columns = (int)ceil(sqrt(viewCount));
+	int rows = (viewCount + columns - 1) / columns;
+	pool->run([columns, rows](int v) {
+		double w = (double)screen_width / columns;
+		double h = (double)screen_height / rows;
+		draw(views[v], (v % columns) * w, (v / columns) * h, w, h);
+	}, viewCount);
 
-	for (int i = 1; i < count - 1; i++)
-	{
-		double dx1, dy1, dx2, dy2, scale1, scale2;
+	surface.color(0, 0, 0);
+	surface.clear();
 
-		dx1 = (double)in[i].x - (double)in[i - 1].x;
-		dy1 = (double)in[i].y - (double)in[i - 1].y;
-		dx2 = (double)in[i + 1].x - (double)in[i].x;
-		dy2 = (double)in[i + 1].y - (double)in[i].y;
+	// surface.color(0, 0, 0, 0.5);
+	// // surface.blend(polyblend);
+	// surface.color(0, 0, 0, 0);
+	// surface.rectangle(&fillRect);
 
-		scale1 = norm(dx1, dy1, normtype); 
-		scale2 = norm(dx2, dy2, normtype); 
+	for (int v = 0; v < viewCount; v++)
+		surface.geometry(views[v].trackverts, views[v].kept * 2, triangles, (views[v].kept - 1) * 6);
+	// surface.blend(SDL_BLENDMODE_BLEND);
 
-		assert(scale1 != 0);
-		assert(scale2 != 0);
+	// surface.color(1, 1, 1, 0.5);
+	
+	// surface.color(0, 0, 0, 0.5);
+	// surface.curve(waveform, waveSize);
+	// surface.curve(Lcurves, waveSize);
+	// surface.curve(Rcurves, waveSize);
 
-		dx = (dx1 / scale1 + dx2 / scale2) / 2;
-		dy = (dy1 / scale1 + dy2 / scale2) / 2;
+	for (int v = 0; v < viewCount; v++)
+		surface.geometry(views[v].curveverts, views[v].kept * 2, triangles, (views[v].kept - 1) * 6);
 
-		// scale = norm(dx, dy);
-		scale = 1; // some flexibility -- nicer corners!
-		normals[i] = { (float)(dy / scale), (float)(-dx / scale) };
-	}
+	mod += modfreq / FRAMERATE;
+	phase += freq / FRAMERATE;
+	phase -= int(phase);
+
+	surface.display();
 }
 
-void move(SDL_FPoint* in, SDL_FPoint* out, SDL_FPoint* normals, double push, int count)
+// run the file or null device through process() in place of the input device
+void feed(bool paced)
 {
-	for (int i = 0; i < count; i++)
+	if (file != "")
+		A.render(file, in_chans, out_chans, true);
+	else
 	{
-		out[i] = { (float)(in[i].x + push * normals[i].x), (float)(in[i].y + push * normals[i].y) };
+		Wave<double>* forms[4] = {&saw, &square, &triangle, &cycle};
+		std::string names[4] = {"saw", "square", "triangle", "cycle"};
+		Wave<double>* form = NULL; // noise
+		for (int i = 0; i < 4; i++)
+			if (synthetic == names[i])
+				form = forms[i];
+
+		A.simulate(form, seconds, in_chans, out_chans, paced, true);
 	}
+	finished = true;
 }
 
-
 int main(int argc, char* argv[])
 {
 	args(argc, argv);
+	allocate();
+
+	SDL_DisplayMode DM;
+	RenderWindow* window = NULL;
+	FILE* video = NULL;
 
-	if (SDL_Init(SDL_INIT_VIDEO) > 0)
+	if (headless != "")
 	{
-		std::cout << "SDL_Init has failed. SDL_ERROR: " << SDL_GetError() << std::endl;
+		// one pixel per screen unit. on the CPU a 1080p frame takes 30 ms for a
+		// sine to 300 ms for noise (one core, portable build; see Canvas.h), so
+		// the input is never paced to a clock: every frame's worth of it is drawn,
+		// however long that takes
+		screen_width = width;
+		screen_height = height;
+		video = fopen(headless.c_str(), "wb");
+		if (video == NULL)
+		{
+			std::cout << "Failed to open " << headless << std::endl;
+			std::exit(1);
+		}
+		canvas = new Canvas(screen_width, screen_height, false, video);
 	}
+	else
+	{
+		if (SDL_Init(SDL_INIT_VIDEO) > 0)
+		{
+			std::cout << "SDL_Init has failed. SDL_ERROR: " << SDL_GetError() << std::endl;
+		}
 
-	SDL_DisplayMode DM;
-	SDL_GetCurrentDisplayMode(0, &DM);
-	screen_width = fullscreen ? DM.w : width;
-	screen_height = fullscreen ? DM.h : height;
+		SDL_GetCurrentDisplayMode(0, &DM);
+		screen_width = fullscreen ? DM.w : width;
+		screen_height = fullscreen ? DM.h : height;
+
+		window = new RenderWindow("Scope", screen_width, screen_height, highDPI, fullscreen ? SDL_WINDOW_FULLSCREEN_DESKTOP : 0); 
+		// window->blend(SDL_BLENDMODE_ADD);
 
-	RenderWindow window("Scope", screen_width, screen_height, highDPI, fullscreen ? SDL_WINDOW_FULLSCREEN_DESKTOP : 0); 
-	// window.blend(SDL_BLENDMODE_ADD);
+		if (mouse)
+		{
+			SDL_SetRelativeMouseMode(SDL_FALSE);
+		}
+		else
+			SDL_SetRelativeMouseMode(SDL_TRUE);
+	}
 
-	if (mouse)
+	density = window ? window->get_scale() : canvas->get_scale();
+	
+	if (recording != "")
 	{
-		SDL_SetRelativeMouseMode(SDL_FALSE);
+		recorder = new Recorder(recording, in_chans, SR, depth);
+		if (!recorder->start())
+		{
+			delete recorder;
+			recorder = NULL;
+		}
 	}
+
+	std::thread feeder; // runs a file or a null device through process() in place of the device
+	if (canvas)
+		feed(false); // headless: the input drives the drawing on this thread, as fast as it can go
 	else
-		SDL_SetRelativeMouseMode(SDL_TRUE);
-	
-	A.startup(in_chans, out_chans, true, in_device, out_device); // startup audio engine
+	{
+		analysis->start();
+		if (file != "" || synthetic != "")
+			feeder = std::thread(feed, paced);
+		else
+			A.startup(in_chans, out_chans, true, in_device, out_device); // startup audio engine
+	}
 
-	bool running = true;
+	bool running = (window != NULL);
 	SDL_Event event;
 
 	while (running)
@@ -275,35 +547,33 @@ int main(int argc, char* argv[])
 				}
 				else if (event.key.keysym.sym == SDLK_LEFT)
 				{
-					dtime += 1;
-					dtime = std::min(dtime, SR - 1);
+					params.set(delaytime, std::min(params.staged(delaytime) + 1, SR - 1.0));
 				}
 				else if (event.key.keysym.sym == SDLK_RIGHT)
 				{
-					dtime -= 1;
-					dtime = std::max(100, dtime);
+					params.set(delaytime, std::max(100.0, params.staged(delaytime) - 1));
 				}
 				else if (event.key.keysym.sym == SDLK_DOWN)
 				{
-					gain -= 0.05;
+					zoom -= 0.05;
 				}
 				else if (event.key.keysym.sym == SDLK_UP) 
 				{
-					gain += 0.05;
+					zoom += 0.05;
 				}
 				
 				if (event.key.keysym.sym == SDLK_SPACE) 
 				{
-					distorted = !distorted;
+					params.set(distortion, params.staged(distortion) > 0.5 ? 0 : 1);
 				}
 
 				if (event.key.keysym.sym == SDLK_f)
 				{
 					fullscreen = !fullscreen;
 					if (fullscreen)
-						SDL_SetWindowFullscreen(window.sdl_window(), SDL_WINDOW_FULLSCREEN_DESKTOP);
+						SDL_SetWindowFullscreen(window->sdl_window(), SDL_WINDOW_FULLSCREEN_DESKTOP);
 					else
-						SDL_SetWindowFullscreen(window.sdl_window(), 0);
+						SDL_SetWindowFullscreen(window->sdl_window(), 0);
 
 					SDL_GetCurrentDisplayMode(0, &DM);
 
@@ -325,97 +595,63 @@ int main(int argc, char* argv[])
 			}
 		}
 
-		gauss(waveform + waveSize * (!flipped), normals + waveSize * (!flipped), waveSize);
-		move(waveform + waveSize * (!flipped), Loffsets + waveSize * (!flipped), normals + waveSize * (!flipped), pushoff, waveSize);
-		move(waveform + waveSize * (!flipped), Roffsets + waveSize * (!flipped), normals + waveSize * (!flipped), -pushoff, waveSize);
-
-		move(waveform + waveSize * (!flipped), Lcurves + waveSize * (!flipped), normals + waveSize * (!flipped), 5, waveSize);
-		move(waveform + waveSize * (!flipped), Rcurves + waveSize * (!flipped), normals + waveSize * (!flipped), -5, waveSize);
-
-
-		// memcpy(trackverts + waveSize * (!flipped) * 6, oldtrack, waveSize * 6 * sizeof(SDL_Vertex));
-		// memcpy(curveverts + waveSize * (!flipped) * 6, oldcurve, waveSize * 6 * sizeof(SDL_Vertex));
-
-		int j = waveSize * (!flipped) * 6;
-		int k = j;
-		SDL_Color color, core;
-		for (int i = 0; i < waveSize - 1; i++)
-		{
-			unsigned char R = (unsigned char)(255 * (1 + sin(2 * PI * (0.0 / 3 * cos(/* toggle color change */ 0 * mod * freq / modfreq) / 2 + 1 * (double)i / waveSize ))) / 2);
-			unsigned char G = (unsigned char)(255 * (1 + sin(2 * PI * (1.0 / 3 * cos(/* toggle color change */ 0 * mod * freq / modfreq) / 2 + 1 * (double)i / waveSize ))) / 2);
-			unsigned char B = (unsigned char)(255 * (1 + sin(2 * PI * (2.0 / 3 * cos(/* toggle color change */ 0 * mod * freq / modfreq) / 2 + 1 * (double)i / waveSize ))) / 2);
-			// unsigned char B = 0;
-
-			color = SDL_Color { R, G, B, (unsigned char)(10) };
-			core = SDL_Color { (unsigned char)255, (unsigned char)255, (unsigned char)255, (unsigned char)(128) };
-			// color = SDL_Color{ 255, 255, 255, 12 };
-
-			trackverts[j++] = { SDL_FPoint{ (Roffsets + waveSize * (!flipped))[i].x, (Roffsets + waveSize * (!flipped))[i].y }, color, SDL_FPoint{ 0 } };
-			trackverts[j++] = { SDL_FPoint{ (Roffsets + waveSize * (!flipped))[i + 1].x, (Roffsets + waveSize * (!flipped))[i + 1].y }, color, SDL_FPoint{ 0 } };
-			trackverts[j++] = { SDL_FPoint{ (Loffsets + waveSize * (!flipped))[i].x, (Loffsets + waveSize * (!flipped))[i].y }, color, SDL_FPoint{ 0 } };
-
-			trackverts[j++] = { SDL_FPoint{ (Loffsets + waveSize * (!flipped))[i].x, (Loffsets + waveSize * (!flipped))[i].y }, color, SDL_FPoint{ 0 } };
-			trackverts[j++] = { SDL_FPoint{ (Loffsets + waveSize * (!flipped))[i + 1].x, (Loffsets + waveSize * (!flipped))[i + 1].y }, color, SDL_FPoint{ 0 } };
-			trackverts[j++] = { SDL_FPoint{ (Roffsets + waveSize * (!flipped))[i + 1].x, (Roffsets + waveSize * (!flipped))[i + 1].y }, color, SDL_FPoint{ 0 } };
-
-
-			curveverts[k++] = { SDL_FPoint{ (Rcurves + waveSize * (!flipped))[i].x, (Rcurves + waveSize * (!flipped))[i].y }, core, SDL_FPoint{ 0 } };
-			curveverts[k++] = { SDL_FPoint{ (Rcurves + waveSize * (!flipped))[i + 1].x, (Rcurves + waveSize * (!flipped))[i + 1].y }, core, SDL_FPoint{ 0 } };
-			curveverts[k++] = { SDL_FPoint{ (Lcurves + waveSize * (!flipped))[i].x, (Lcurves + waveSize * (!flipped))[i].y }, core, SDL_FPoint{ 0 } };
-
-			curveverts[k++] = { SDL_FPoint{ (Lcurves + waveSize * (!flipped))[i].x, (Lcurves + waveSize * (!flipped))[i].y }, core, SDL_FPoint{ 0 } };
-			curveverts[k++] = { SDL_FPoint{ (Lcurves + waveSize * (!flipped))[i + 1].x, (Lcurves + waveSize * (!flipped))[i + 1].y }, core, SDL_FPoint{ 0 } };
-			curveverts[k++] = { SDL_FPoint{ (Rcurves + waveSize * (!flipped))[i + 1].x, (Rcurves + waveSize * (!flipped))[i + 1].y }, core, SDL_FPoint{ 0 } };
-		}
-
-		// trackverts[waveSize * (!flipped) * 6 - 6] = { SDL_FPoint{ (Roffsets + waveSize * (flipped))[0].x, (Roffsets + waveSize * (flipped))[0].y }, color, SDL_FPoint{ 0 } };
-		// trackverts[waveSize * (!flipped) * 6 - 5] = { SDL_FPoint{ (Roffsets + waveSize * (flipped))[0 + 1].x, (Roffsets + waveSize * (flipped))[0 + 1].y }, color, SDL_FPoint{ 0 } };
-		// trackverts[waveSize * (!flipped) * 6 - 4] = { SDL_FPoint{ (Loffsets + waveSize * (flipped))[0].x, (Loffsets + waveSize * (flipped))[0].y }, color, SDL_FPoint{ 0 } };
-		// trackverts[waveSize * (!flipped) * 6 - 3] = { SDL_FPoint{ (Loffsets + waveSize * (flipped))[0].x, (Loffsets + waveSize * (flipped))[0].y }, color, SDL_FPoint{ 0 } };
-		// trackverts[waveSize * (!flipped) * 6 - 2] = { SDL_FPoint{ (Loffsets + waveSize * (flipped))[0 + 1].x, (Loffsets + waveSize * (flipped))[0 + 1].y }, color, SDL_FPoint{ 0 } };
-		// trackverts[waveSize * (!flipped) * 6 - 1] = { SDL_FPoint{ (Roffsets + waveSize * (flipped))[0 + 1].x, (Roffsets + waveSize * (flipped))[0 + 1].y }, color, SDL_FPoint{ 0 } };
-
-		window.color(0, 0, 0);
-		window.clear();
-
-		while (!ready)
-		{
-			usleep(100);
-		}
-
-		// window.color(0, 0, 0, 0.5);
-		// // window.blend(polyblend);
-		// window.color(0, 0, 0, 0);
-		// window.rectangle(&fillRect);
-
-		// window.geometry(oldtrack, waveSize * 6);
-		// window.geometry(oldcurve, waveSize * 6);
-
-		window.geometry(trackverts + waveSize * (!flipped) * 6, waveSize * 6);
-		// window.blend(SDL_BLENDMODE_BLEND);
-
-		// window.color(1, 1, 1, 0.5);
-		
-		// window.color(0, 0, 0, 0.5);
-		// window.curve(waveform + waveSize * (!flipped), waveSize);
-		// window.curve(Lcurves + waveSize * (!flipped), waveSize);
-		// window.curve(Rcurves + waveSize * (!flipped), waveSize);
-
-		window.geometry(curveverts + waveSize * (!flipped) * 6, waveSize * 6);
-		ready = false;
-
-		mod += modfreq / FRAMERATE;
-		phase += freq / FRAMERATE;
-		phase -= int(phase);
-
-
-		window.display();
+		// sleep until a frame's worth of trace has arrived, or for a frame period
+		// if the analysis thread is behind, then take everything it has done.
+		// it fills every view's ring in the same block, so the first one will do
+		views[0].frames->wait(waveSize, 1000 / FRAMERATE);
+		show(*window, INT_MAX);
+
+		double latest = views[0].latest.load(std::memory_order_relaxed);
+		for (int v = 1; v < viewCount; v++)
+			latest = std::min(latest, views[v].latest.load(std::memory_order_relaxed));
+		if (A.running) // a file's or null device's times aren't a clock's
+			lag += Pa_GetStreamTime(A.stream) - latest;
+		displayed++;
+
+		if (finished)
+			running = false;
 	}
 
-	A.shutdown(); // shutdown audio engine
-	window.~RenderWindow();
-
-	SDL_Quit();
+	quitting = true;
+	if (feeder.joinable())
+		feeder.join();
+	bool live = A.running; // whether display lag was measured
+	A.shutdown(timings); // shutdown audio engine
+	analysis->stop();
+	if (recorder)
+	{
+		recorder->stop();
+		std::cout << recording << ": " << (double)recorder->written() / SR << " s recorded, " << recorder->dropped() << " frames dropped" << std::endl;
+		delete recorder;
+	}
+	if (A.realtime && A.entered)
+		A.realtime->report(std::cout);
+	std::cout << "callbacks: " << A.timing.xruns() << " xruns, worst " << 1e6 * A.timing.worst() << " us" << std::endl;
+	if (!canvas)
+		std::cout << "analysis: " << analysis->blocks() << " blocks, " << analysis->late() << " late, " << analysis->dropped() << " dropped, "
+			  << analysis->overruns() << " frames lost to a full queue, lateness mean " << 1000 * analysis->lateness() << " ms, worst "
+			  << 1000 * analysis->worst() << " ms, load " << analysis->load() << std::endl;
+	long overruns = 0, underruns = 0;
+	for (int v = 0; v < viewCount; v++)
+	{
+		overruns += views[v].frames->overruns();
+		underruns += views[v].frames->underruns();
+	}
+	std::cout << "rings: " << overruns << " frames dropped, " << underruns << " short reads";
+	if (live)
+		std::cout << ", " << 1000 * lag / std::max(1l, displayed) << " ms mean display lag";
+	std::cout << std::endl;
+	if (canvas)
+	{
+		std::cout << headless << ": " << displayed << " frames of " << canvas->width() << " x " << canvas->height() << " RGBA" << std::endl;
+		delete canvas;
+		fclose(video);
+	}
+	else
+	{
+		delete window;
+		SDL_Quit();
+	}
 
 	return 0;
 }
@@ -446,6 +682,21 @@ void args(int argc, char *argv[])
 		.scan<'i', int>()
 		.help("input channel selector (in [0, if - 1])");
 
+	program.add_argument("-a", "--all")
+		.help("watch every input channel, tiled")
+		.default_value(false)
+		.implicit_value(true);
+
+	program.add_argument("--subspace")
+		.default_value<int>(0)
+		.scan<'i', int>()
+		.help("draw the plane a subspace tracker follows through an embedding of this many delays over 50 ms, instead of each sample against its delayed copy; 0 is off");
+
+	program.add_argument("--decimate")
+		.help("when the analysis falls behind, analyze every 2nd, 4th, ... sample instead of dropping blocks")
+		.default_value(false)
+		.implicit_value(true);
+
 	program.add_argument("-o", "--output")
 		.default_value<int>((int)def_out)
 		.required()
@@ -458,6 +709,75 @@ void args(int argc, char *argv[])
 		.scan<'i', int>()
 		.help("channels per frame of output");
 
+	program.add_argument("-sr", "--rate")
+		.default_value<int>((int)SR)
+		.required()
+		.scan<'i', int>()
+		.help("sample rate");
+
+	program.add_argument("-b", "--bsize")
+		.default_value<int>((int)bsize)
+		.required()
+		.scan<'i', int>()
+		.help("frames per callback");
+
+	program.add_argument("-f", "--file")
+		.default_value<std::string>("")
+		.help("watch a WAV file (- for stdin), as fast as it can be read, instead of the input device");
+
+	program.add_argument("-n", "--null")
+		.default_value<std::string>("")
+		.help("watch saw, square, triangle, cycle or noise from a null device instead of the input device");
+
+	program.add_argument("-s", "--seconds")
+		.default_value<double>((double)seconds)
+		.scan<'g', double>()
+		.help("how long the null device runs");
+
+	program.add_argument("-r", "--free")
+		.help("let the null device run as fast as possible instead of at the device's cadence")
+		.default_value(false)
+		.implicit_value(true);
+
+	program.add_argument("-rt", "--realtime")
+		.default_value<int>(-1)
+		.scan<'i', int>()
+		.help("set up the audio thread for real time: flush denormals, lock memory, and use SCHED_FIFO at this priority if it is over 0");
+
+	program.add_argument("-p", "--pin")
+		.default_value<int>(-1)
+		.scan<'i', int>()
+		.help("pin the audio thread to this cpu (with -rt)");
+
+	program.add_argument("-t", "--timings")
+		.default_value<std::string>("")
+		.help("file to write callback timing statistics to at shutdown");
+
+	program.add_argument("-e", "--error")
+		.default_value<double>((double)tolerance)
+		.scan<'g', double>()
+		.help("opt-in: pixels the drawn curve may stray from the full one when dropping points; 0 (the default) draws every point. "
+			  "dropping saves vertices for the renderer, but the test costs the CPU more than it saves on busy input, so a frame takes longer");
+
+	program.add_argument("--headless")
+		.default_value<std::string>("")
+		.help("draw on the CPU into this file, as raw RGBA frames of 1920 x 1080, instead of opening a window. the input (-f, or -n, cycle by default) runs unpaced "
+			  "and every frame's worth of it is drawn, at 30 ms (a sine) to 300 ms (noise) a frame on one core: 3 to 30 frames a second, not real time");
+
+	program.add_argument("--frames")
+		.default_value<long>(0l)
+		.scan<'i', long>()
+		.help("frames to draw with --headless (it sets -s if that isn't given); 0 draws until the input runs out");
+
+	program.add_argument("-w", "--record")
+		.default_value<std::string>("")
+		.help("WAV file to record every input channel to, as 32-bit float");
+
+	program.add_argument("--pcm24")
+		.help("record packed 24-bit PCM instead of float")
+		.default_value(false)
+		.implicit_value(true);
+
 	program.add_argument("-d", "--devices")
 		.help("list audio device names and exits")
 		.default_value(false)
@@ -477,8 +797,37 @@ void args(int argc, char *argv[])
 	in_device = program.get<int>("-i");
 	in_chans = program.get<int>("-if");
 	in_channel = program.get<int>("-c");
+	every = program.get<bool>("-a");
+	tracked = std::max(0, program.get<int>("--subspace"));
+	if (program.get<bool>("--decimate"))
+		overload = Policy::decimate;
 	out_device = program.get<int>("-o");
 	out_chans = program.get<int>("-of");
+	timings = program.get<std::string>("-t");
+	file = program.get<std::string>("-f");
+	synthetic = program.get<std::string>("-n");
+	seconds = program.get<double>("-s");
+	paced = !program.get<bool>("-r");
+	tolerance = std::max(0.0, program.get<double>("-e"));
+	headless = program.get<std::string>("--headless");
+	frames = std::max(0l, program.get<long>("--frames"));
+	if (headless != "" && file == "" && synthetic == "")
+		synthetic = "cycle";
+	if (headless != "" && frames > 0 && !program.is_used("-s"))
+		seconds = (double)(frames + 1) / FRAMERATE; // a spare one for the blocks' rounding
+	recording = program.get<std::string>("-w");
+	if (program.get<bool>("--pcm24"))
+		depth = Recorder::pcm24;
+	SR = std::min(MAX_SR, std::max(FRAMERATE * 2, program.get<int>("-sr")));
+	A.timing.sampleRate(SR); // A was built before the rate was known
+	bsize = std::max(1, program.get<int>("-b"));
+	A.bsize = bsize;
+
+	if (program.get<int>("-rt") >= 0)
+	{
+		setup = Realtime(program.get<int>("-rt"), program.get<int>("-p"));
+		A.realtime = &setup;
+	}
 
 	Audio::initialize(program.is_used("-d"));
 